@@ -75,6 +75,20 @@ fi
 # 5. load current (in Ampere)    -> IL  -> min    0 max  100
 # 6. operational charge state    -> CS  -> min    0 max    5
 # 7. Daytime (sunrise..sunset) flag (0=day, 1=night)
+# 8. PV energy counter (in Wh)            -> epv   -> min 0
+# 9. battery charge energy counter (Wh)   -> echg  -> min 0
+# 10. battery discharge energy counter    -> edis  -> min 0
+# 11. load energy counter (in Wh)         -> eload -> min 0
+# 12. controller yield total H19 (in Wh)  -> yldt  -> min 0
+# 13. controller yield today H20 (in Wh)  -> yldd  -> min 0
+# 14. controller yield yesterday H22 (Wh) -> ylds  -> min 0
+#
+# The energy counters are integrated by getvictron and only
+# increase. The energy of a period is the difference of the
+# counter values at its start and end. Stored as GAUGE, so
+# the MAX RRA's keep the counter value at the end of a row.
+# The yield values are the controllers own counters, they
+# come in 10 Wh resolution.
 #
 # The data slots are allocated as follows:
 # ----------------------------------------
@@ -99,6 +113,13 @@ DS:ppnl:GAUGE:300:0:1000     \
 DS:load:GAUGE:300:0:100      \
 DS:opcs:GAUGE:300:0:5        \
 DS:dayt:GAUGE:300:0:1        \
+DS:epv:GAUGE:300:0:U         \
+DS:echg:GAUGE:300:0:U        \
+DS:edis:GAUGE:300:0:U        \
+DS:eload:GAUGE:300:0:U       \
+DS:yldt:GAUGE:300:0:U        \
+DS:yldd:GAUGE:300:0:U        \
+DS:ylds:GAUGE:300:0:U        \
 RRA:AVERAGE:0.5:1:20160      \
 RRA:AVERAGE:0.5:60:13200     \
 RRA:AVERAGE:0.5:1440:6580    \
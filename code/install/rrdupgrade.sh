@@ -0,0 +1,101 @@
+#!/bin/bash
+##########################################################
+# rrdupgrade.sh 20261018 agent
+#
+# This script adds the data sources that were introduced
+# after the RRD database was created: the energy counters
+# epv, echg, edis, eload and the controller yield counters
+# yldt, yldd, ylds. The collected data is kept, the new
+# data sources start as unknown.
+#
+# Until it ran, solar-data.sh only updates the original
+# data sources. setup.sh calls it after rrdcreate.sh, and
+# running it again does nothing if the database is up to
+# date.
+##########################################################
+echo "rrdupgrade.sh: Upgrading RRD database file for pi-solar"
+
+readconfig() {
+   local ARRAY="$1"
+   local KEY VALUE 
+   local IFS='='
+   declare -g -A "$ARRAY"
+   while read; do
+      # here assumed that comments may not be indented
+      [[ $REPLY == [^#]*[^$IFS]${IFS}[^$IFS]* ]] && {
+          read KEY VALUE <<< "$REPLY"
+          [[ -n $KEY ]] || continue
+          eval "$ARRAY[$KEY]=\"\$VALUE\""
+      }
+   done 
+}
+
+##########################################################
+# Check for the config file, and source it
+##########################################################
+CONFIG=../etc/pi-solar.conf
+if [[ ! -f $CONFIG ]]; then
+  echo "rrdupgrade.sh: Error - cannot find config file [$CONFIG]" >&2
+  exit -1
+fi
+readconfig MYCONFIG < "$CONFIG"
+
+RRD=${MYCONFIG[pi-solar-dir]}/rrd/${MYCONFIG[pi-solar-rrd]}
+
+if [[ ! -f $RRD ]]; then
+  echo "rrdupgrade.sh: Error - cannot find RRD database [$RRD]" >&2
+  exit -1
+fi
+
+if ! [ -x "$(command -v rrdtool)" ]; then
+  echo "rrdupgrade.sh: Error - rrdtool is not installed." >&2
+  exit -1
+fi
+
+##########################################################
+# Collect the data sources the database does not have yet.
+# Same definitions as in rrdcreate.sh.
+##########################################################
+NEWDS=(
+DS:epv:GAUGE:300:0:U
+DS:echg:GAUGE:300:0:U
+DS:edis:GAUGE:300:0:U
+DS:eload:GAUGE:300:0:U
+DS:yldt:GAUGE:300:0:U
+DS:yldd:GAUGE:300:0:U
+DS:ylds:GAUGE:300:0:U
+)
+RRDINFO=`rrdtool info $RRD`
+ADDDS=()
+for DS in "${NEWDS[@]}"; do
+  NAME=`echo $DS | cut -d ":" -f 2`
+  if ! echo "$RRDINFO" | grep -q "^ds\[$NAME\]"; then
+    ADDDS+=($DS)
+  fi
+done
+
+if [[ ${#ADDDS[@]} == 0 ]]; then
+  echo "rrdupgrade.sh: RRD database [$RRD] is up to date."
+  exit 0
+fi
+echo "rrdupgrade.sh: Adding ${ADDDS[*]}"
+
+##########################################################
+# Keep a copy of the old database, then add the new DS.
+# rrdtool tune DS: needs rrdtool 1.5 or newer.
+##########################################################
+BACKUP=$RRD.`date +%Y%m%d%H%M`
+echo "rrdupgrade.sh: Saving database copy to [$BACKUP]."
+cp -p $RRD $BACKUP || exit -1
+
+rrdtool tune $RRD "${ADDDS[@]}"
+
+NAME=`echo ${ADDDS[-1]} | cut -d ":" -f 2`
+if rrdtool info $RRD | grep -q "^ds\[$NAME\]"; then
+  echo "rrdupgrade.sh: Database [$RRD] upgraded."
+else
+  echo "rrdupgrade.sh: Could not upgrade database [$RRD], restore from [$BACKUP]."
+  exit -1
+fi
+
+############# end of rrdupgrade.sh #######################
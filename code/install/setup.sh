@@ -215,7 +215,8 @@ echo "Done."
 echo
 
 echo "##########################################################"
-echo "# 11. rrdcreate creates the empty RRD database"
+echo "# 11. rrdcreate creates the empty RRD database, an"
+echo "# existing database gets the new DS from rrdupgrade"
 echo "##########################################################"
 ./rrdcreate.sh
 RRD_DIR=${MYCONFIG[pi-solar-dir]}/rrd
@@ -226,6 +227,12 @@ if [[ ! -e $RRD ]]; then
    exit 1
 fi
 
+./rrdupgrade.sh
+if [[ $? != 0 ]]; then
+   echo "Error upgrading the RRD database."
+   exit 1
+fi
+
 ls -l $RRD
 echo "Done."
 echo
@@ -0,0 +1,240 @@
+/* ------------------------------------------------------------ *
+ * file:        ephem.c                                         *
+ * purpose:     Precomputed sun position table for one site,    *
+ *              see ephem.h for the file layout. The functions: *
+ *                 ep_create()  calculate and write the table   *
+ *                 ep_open() / ep_close()                       *
+ *                 ep_lookup()  interpolate the sun position    *
+ *                 ep_localhr() rise/set time as local hours    *
+ *                                                              *
+ * author:      10/18/2026 agent                                *
+ * ------------------------------------------------------------ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <errno.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "ephem.h"
+
+#define EP_DEG (360.0 / 65536.0)       // degrees per fixed point unit
+
+/* ------------------------------------------------------------ *
+ * ep_fixed() converts degrees to fixed point, 360 wraps to 0.  *
+ * ------------------------------------------------------------ */
+static uint16_t ep_fixed(double deg) {
+   return (uint16_t) (lround(deg * EP_SCALE) & 0xffff);
+}
+
+/* ------------------------------------------------------------ *
+ * ep_hour() converts SPA local fractional hours of the day     *
+ * starting at midnight (Unix timestamp) to a Unix timestamp.   *
+ * ------------------------------------------------------------ */
+static int64_t ep_hour(double hour, int64_t midnight) {
+   if(hour < -99998) return(EP_NONE);
+   return(midnight + llround(hour * 3600.0));
+}
+
+/* ------------------------------------------------------------ *
+ * write_table() calculates the table into fp, one day of       *
+ * samples per spa_calculate_batch() call.                      *
+ * ------------------------------------------------------------ */
+static int write_table(FILE *fp, const ep_header *hdr, const spa_data *spa) {
+   int spd = 86400 / hdr->step;
+   time_t *ts = malloc(spd * sizeof(time_t));
+   double *val = malloc(3 * spd * sizeof(double));
+   ep_sample *smp = malloc(spd * sizeof(ep_sample));
+   ep_day *day = malloc(hdr->days * sizeof(ep_day));
+   int result = -1;
+
+   if(ts == NULL || val == NULL || smp == NULL || day == NULL) {
+      printf("Error: out of memory creating the sun position table.\n");
+      goto done;
+   }
+   spa_data site = *spa;
+   site.function = SPA_ALL;
+
+   /* ---------------------------------------------------------- *
+    * Day records: transit, rise and set from a local noon batch *
+    * ---------------------------------------------------------- */
+   time_t noon[1];
+   spa_batch rts = { &val[0], &val[1], NULL, &val[2], &val[3], &val[4] };
+   for(uint32_t d = 0; d < hdr->days; d++) {
+      int64_t midnight = hdr->start + (int64_t) d * 86400;
+      noon[0] = midnight + 43200;
+      int rc = spa_calculate_batch(&site, noon, 1, &rts);
+      if(rc != 0) {
+         printf("Error: SPA input value check failed, error code %d.\n", rc);
+         goto done;
+      }
+      day[d].suntransit = ep_hour(val[2], midnight);
+      day[d].sunrise    = ep_hour(val[3], midnight);
+      day[d].sunset     = ep_hour(val[4], midnight);
+   }
+   if(fwrite(hdr, sizeof(ep_header), 1, fp) != 1 ||
+      fwrite(day, sizeof(ep_day), hdr->days, fp) != hdr->days) goto done;
+
+   /* ---------------------------------------------------------- *
+    * Samples, the last one is the midnight after the last day   *
+    * ---------------------------------------------------------- */
+   spa_batch out = { val, val + spd, val + 2*spd, NULL, NULL, NULL };
+   for(uint32_t i = 0; i < hdr->count; i = i + spd) {
+      int n = (hdr->count - i < (uint32_t) spd) ? (int) (hdr->count - i) : spd;
+      for(int j = 0; j < n; j++) ts[j] = hdr->start + (int64_t) (i + j) * hdr->step;
+      if(spa_calculate_batch(&site, ts, n, &out) != 0) goto done;
+      for(int j = 0; j < n; j++) {
+         smp[j].zenith    = ep_fixed(out.zenith[j]);
+         smp[j].azimuth   = ep_fixed(out.azimuth[j]);
+         smp[j].incidence = ep_fixed(out.incidence[j]);
+      }
+      if(fwrite(smp, sizeof(ep_sample), n, fp) != (size_t) n) goto done;
+   }
+   result = 0;
+
+done:
+   free(ts);
+   free(val);
+   free(smp);
+   free(day);
+   return(result);
+}
+
+int ep_create(const char *file, const spa_data *spa, time_t start, int days, int step) {
+   if(step < 1 || 86400 % step != 0) {
+      printf("Error: table step %d does not divide a day.\n", step);
+      return(-1);
+   }
+   if(days < 1) {
+      printf("Error: table needs at least one day, got %d.\n", days);
+      return(-1);
+   }
+   ep_header hdr;
+   memset(&hdr, 0, sizeof(hdr));
+   hdr.magic        = EP_MAGIC;
+   hdr.step         = step;
+   hdr.start        = start;
+   hdr.days         = days;
+   hdr.count        = days * (86400 / step) + 1;
+   hdr.latitude     = spa->latitude;
+   hdr.longitude    = spa->longitude;
+   hdr.timezone     = spa->timezone;
+   hdr.elevation    = spa->elevation;
+   hdr.slope        = spa->slope;
+   hdr.azm_rotation = spa->azm_rotation;
+
+   /* ------------------------------------------------------------ *
+    * Write a temp file next to it, then rename() it into place.   *
+    * ------------------------------------------------------------ */
+   char tmpfile[4096];
+   if(snprintf(tmpfile, sizeof(tmpfile), "%s.tmp", file) >= (int) sizeof(tmpfile)) {
+      printf("Error: file name %s is too long.\n", file);
+      return(-1);
+   }
+   FILE *fp = fopen(tmpfile, "w");
+   if(! fp) {
+      printf("Error open %s for writing.\n", tmpfile);
+      return(-1);
+   }
+   int result = write_table(fp, &hdr, spa);
+   if(fclose(fp) != 0 || result != 0) {
+      printf("Error writing %s.\n", tmpfile);
+      remove(tmpfile);
+      return(-1);
+   }
+   if(rename(tmpfile, file) != 0) {
+      printf("Error: cannot rename %s to %s.\n", tmpfile, file);
+      remove(tmpfile);
+      return(-1);
+   }
+   return(0);
+}
+
+/* ------------------------------------------------------------ *
+ * ep_open() maps the table read-only. The file size must match *
+ * the day and sample counts of the header.                     *
+ * ------------------------------------------------------------ */
+int ep_open(ephem *ep, const char *file) {
+   memset(ep, 0, sizeof(ephem));
+   int fd = open(file, O_RDONLY);
+   if(fd < 0) {
+      printf("Error: cannot open sun position table %s: %s\n", file, strerror(errno));
+      return(-1);
+   }
+   struct stat st;
+   if(fstat(fd, &st) != 0) { close(fd); return(-1); }
+   if((size_t) st.st_size < sizeof(ep_header)) {
+      printf("Error: sun position table %s is too short.\n", file);
+      close(fd);
+      return(-1);
+   }
+   void *m = mmap(NULL, st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+   close(fd);
+   if(m == MAP_FAILED) {
+      printf("Error: cannot map sun position table %s\n", file);
+      return(-1);
+   }
+   ep->hdr = m;
+   ep->maplen = st.st_size;
+   ep->day = (const ep_day *) (ep->hdr + 1);
+   ep->smp = (const ep_sample *) (ep->day + ep->hdr->days);
+
+   const ep_header *h = ep->hdr;
+   if(h->magic != EP_MAGIC || h->step < 1 || 86400 % h->step != 0 || h->days < 1 ||
+      h->count != h->days * (86400 / h->step) + 1 ||
+      ep->maplen != sizeof(ep_header) + h->days * sizeof(ep_day) + h->count * sizeof(ep_sample)) {
+      printf("Error: %s is not a valid sun position table.\n", file);
+      ep_close(ep);
+      return(-1);
+   }
+   return(0);
+}
+
+void ep_close(ephem *ep) {
+   if(ep->hdr) munmap((void *) ep->hdr, ep->maplen);
+   memset(ep, 0, sizeof(ephem));
+}
+
+int ep_lookup(const ephem *ep, time_t t, long tzoffset, ep_pos *pos) {
+   const ep_header *h = ep->hdr;
+   int64_t off = (int64_t) t - h->start;
+   if(off < 0 || off > (int64_t) (h->count - 1) * h->step) return(-1);
+
+   uint32_t i = off / h->step;
+   if(i == h->count - 1) i--;          // t is the last sample
+   double f = (double) (off - (int64_t) i * h->step) / h->step;
+   const ep_sample *a = &ep->smp[i];
+   const ep_sample *b = a + 1;
+
+   pos->zenith    = (a->zenith + (b->zenith - a->zenith) * f) * EP_DEG;
+   pos->incidence = (a->incidence + (b->incidence - a->incidence) * f) * EP_DEG;
+
+   /* ------------------------------------------------------------ *
+    * The 16 bit difference is the short way around the circle.    *
+    * ------------------------------------------------------------ */
+   double az = a->azimuth + (int16_t) (b->azimuth - a->azimuth) * f;
+   if(az < 0) az = az + 65536.0;
+   else if(az >= 65536.0) az = az - 65536.0;
+   pos->azimuth = az * EP_DEG;
+
+   /* ------------------------------------------------------------ *
+    * The day records start at standard time midnight. With DST    *
+    * the local day starts earlier, so count days in local time.   *
+    * ------------------------------------------------------------ */
+   int64_t local = off + tzoffset - llround(h->timezone * 3600.0);
+   int64_t d = (local < 0) ? 0 : local / 86400;
+   if(d >= h->days) d = h->days - 1;   // midnight after the last day
+   pos->suntransit = ep->day[d].suntransit;
+   pos->sunrise    = ep->day[d].sunrise;
+   pos->sunset     = ep->day[d].sunset;
+   return(0);
+}
+
+double ep_localhr(int64_t t, long tzoffset) {
+   if(t == EP_NONE) return(-99999);
+   int64_t sec = (t + tzoffset) % 86400;
+   if(sec < 0) sec = sec + 86400;
+   return(sec / 3600.0);
+}
@@ -9,7 +9,8 @@
  *                                                              *
  * author:      07/15/2018 Frank4DD                             *
  *                                                              *
- * compile:     gcc spa.c getspa.c -o getspa -lm                *
+ * compile:     gcc spa.c outbuf.c ephem.c getspa.c -o getspa   *
+ *              -lm                                             *
  *                                                              *
  * ------------------------------------------------------------ */
 #include <stdio.h>
@@ -19,7 +20,10 @@
 #include <unistd.h>    // for getopt()
 #include <string.h>    // for strncpy()
 #include <time.h>      // for struct tm
+#include <math.h>      // for fabs()
 #include "spa.h"       //include the SPA header file
+#include "outbuf.h"    // for the buffered html output
+#include "ephem.h"     // for the precomputed sun position table
 
 /* ------------------------------------------------------------ *
  * Global variables and defaults                                *
@@ -32,6 +36,7 @@ long tzoffset = 0;
 char tzstring[255] = "";
 char htmfile[1024] = "";
 int outflag = 0;        // set when arg -f is given
+char ephfile[1024] = ""; // sun position table, set with arg -e
 spa_data spa;           //declare the SPA structure
 float sunrisemin;
 int sunrisesec;
@@ -46,7 +51,7 @@ extern int optind, opterr, optopt;
  * print_usage() prints the programs commandline instructions.  *
  * ------------------------------------------------------------ */
 void usage() {
-   static char const usage[] = "Usage: getspa -t timestamp -x longitude -y latitude -s timezone -f filename\n\n\
+   static char const usage[] = "Usage: getspa -t timestamp -x longitude -y latitude -s timezone -f filename [-e tablefile]\n\n\
 Command line parameters have the following format:\n\
    -t   Unix timestamp, example: 1486784589, optional, defaults to now\n\
    -x   longitude, example: 12.45277778\n\
@@ -54,6 +59,7 @@ Command line parameters have the following format:\n\
    -z   timezone offset in hrs, example: 9, optional, defaults to local system timezone offset\n\
    -s   timezone name, example: \"Europe/Berlin\", optional, prefered instead of -z option\n\
    -f   write html output to file\n\
+   -e   sun position table from mkephem, optional, used if it covers the timestamp\n\
    -v   verbose output flag\n\
    -h   print usage flag\n\n\
 Usage example:\n\
@@ -82,7 +88,7 @@ void parseargs(int argc, char* argv[]) {
 
    if(argc == 1) { usage(); exit(-1); }
 
-   while ((arg = (int) getopt (argc, argv, "t:x:y:z:s:vhf:")) != -1)
+   while ((arg = (int) getopt (argc, argv, "t:x:y:z:s:vhf:e:")) != -1)
       switch (arg) {
          // arg -t timestamp, type: time_t, example: 1486784589
          // optional, defaults to now
@@ -169,6 +175,12 @@ void parseargs(int argc, char* argv[]) {
             strncpy(htmfile, optarg, sizeof(htmfile));
             break;
 
+         // arg -e sun position table, type: string, example: "/home/pi/pi-solar/rrd/ephem.tbl"
+         // optional
+         case 'e':
+            strncpy(ephfile, optarg, sizeof(ephfile)-1);
+            break;
+
          case '?':
             if (isprint (optopt))
                printf ("Error: Unknown option `-%c'.\n", optopt);
@@ -186,33 +198,30 @@ void parseargs(int argc, char* argv[]) {
 
 void write_html(char *file){
    /* -------------------------------------------------------- *
-    *  Open the html file for writing the table data           *
+    *  Render the html in memory, ob_write() puts it in place  *
     * -------------------------------------------------------- */
-   FILE *html;
-   if(! (html=fopen(file, "w"))) {
-      printf("Error open %s for writing.\n", htmfile);
-      exit(-1);
-   }
+   outbuf html = { 0 };
    if(verbose == 1) printf("Debug: Writing to file [%s]\n", file);
    /* -------------------------------------------------------- *
     *  Write the solar tracking data table                     *
     * -------------------------------------------------------- */
-   fprintf(html, "<table><tr>\n");
-   fprintf(html, "<td class=\"sensordata\">Sunrise and Sunset:");
-   fprintf(html, "<span class=\"sensorvalue\"> %d:%02d - %d:%02d</span></td>\n",
+   ob_printf(&html, "<table><tr>\n");
+   ob_printf(&html, "<td class=\"sensordata\">Sunrise and Sunset:");
+   ob_printf(&html, "<span class=\"sensorvalue\"> %d:%02d - %d:%02d</span></td>\n",
            (int) spa.sunrise, (int) sunrisemin, (int) spa.sunset, (int) sunsetmin);
-   fprintf(html, "<td class=\"sensorspace\"></td>\n");
+   ob_printf(&html, "<td class=\"sensorspace\"></td>\n");
 
-   fprintf(html, "<td class=\"sensordata\">Solar Zenith:");
-   fprintf(html, "<span class=\"sensorvalue\">%.6f</span></td>\n", spa.zenith);
-   fprintf(html, "<td class=\"sensorspace\"></td>\n");
+   ob_printf(&html, "<td class=\"sensordata\">Solar Zenith:");
+   ob_printf(&html, "<span class=\"sensorvalue\">%.6f</span></td>\n", spa.zenith);
+   ob_printf(&html, "<td class=\"sensorspace\"></td>\n");
 
-   fprintf(html, "<td class=\"sensordata\">Solar Azimuth:");
-   fprintf(html, "<span class=\"sensorvalue\">%.6f</span></td>\n", spa.azimuth);
-   fprintf(html, "</tr></table>\n");
+   ob_printf(&html, "<td class=\"sensordata\">Solar Azimuth:");
+   ob_printf(&html, "<span class=\"sensorvalue\">%.6f</span></td>\n", spa.azimuth);
+   ob_printf(&html, "</tr></table>\n");
 
+   if(ob_write(&html, file) != 0) exit(-1);
+   ob_free(&html);
    if(verbose == 1) printf("Debug: Finished writing to file [%s]\n", file);
-   fclose(html);
 }
 
 int main (int argc, char *argv[]) {
@@ -293,14 +302,50 @@ int main (int argc, char *argv[]) {
       printf("Function:    %d\n", spa.function);
    }
 
+   /* ------------------------------------------------------------ *
+    * With arg -e, take the values from the sun position table if  *
+    * it was made for this site and panel (elevation, slope and    *
+    * rotation set above) and covers the timestamp.                *
+    * ------------------------------------------------------------ */
+   int fromtable = 0;
+   ephem ep;
+   ep_pos pos;
+   if(ephfile[0] != '\0' && ep_open(&ep, ephfile) == 0) {
+      if(fabs(ep.hdr->latitude - latitude) > 0.001 || fabs(ep.hdr->longitude - longitude) > 0.001 ||
+         fabs(ep.hdr->elevation - spa.elevation) > 0.001 || fabs(ep.hdr->slope - spa.slope) > 0.001 ||
+         fabs(ep.hdr->azm_rotation - spa.azm_rotation) > 0.001)
+         printf("Error: table %s is for a different site or panel, using SPA.\n", ephfile);
+      else if(ep_lookup(&ep, calc_t, tzoffset, &pos) == 0) {
+         spa.zenith     = pos.zenith;
+         spa.azimuth    = pos.azimuth;
+         spa.incidence  = pos.incidence;
+         spa.suntransit = ep_localhr(pos.suntransit, tzoffset);
+         spa.sunrise    = ep_localhr(pos.sunrise, tzoffset);
+         spa.sunset     = ep_localhr(pos.sunset, tzoffset);
+         fromtable = 1;
+      }
+      else if(verbose == 1) printf("Timestamp is outside of table %s, using SPA.\n", ephfile);
+      ep_close(&ep);
+   }
+
    //call the SPA calculate function and pass the SPA structure
-   result = spa_calculate(&spa);
+   if(fromtable == 1) result = 0;
+   else result = spa_calculate(&spa);
    sunrisemin = 60.0*(spa.sunrise - (int)(spa.sunrise));
    sunrisesec = (int) 60.0*(sunrisemin - (int)sunrisemin);
    sunsetmin = 60.0*(spa.sunset - (int)(spa.sunset));
    sunsetsec = (int) 60.0*(sunsetmin - (int)sunsetmin);
 
-   if (verbose == 1) { //check for SPA errors
+   if (verbose == 1 && fromtable == 1) {
+        printf("\nFinal output values from table %s:\n", ephfile);
+        printf("--------------------\n");
+        printf("Zenith:        %.6f degrees\n",spa.zenith);
+        printf("Azimuth:       %.6f degrees\n",spa.azimuth);
+        printf("Incidence:     %.6f degrees\n",spa.incidence);
+        printf("Sunrise:       %02d:%02d:%02d Local Time\n", (int)(spa.sunrise), (int) sunrisemin, sunrisesec);
+        printf("Sunset:        %02d:%02d:%02d Local Time\n", (int)(spa.sunset), (int) sunsetmin, sunsetsec);
+   }
+   else if (verbose == 1) { //check for SPA errors
       if (result == 0) { //check for SPA errors
         printf("Intermediate output values:\n");
         printf("---------------------------\n");
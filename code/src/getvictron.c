@@ -13,7 +13,8 @@
  *                                                              *
  * author:      03/30/2018 Frank4DD http://github.com/fm4dd     *
  *                                                              *
- * compile:	gcc serial.c getvictron.c -o getvictron         *
+ * compile:	gcc serial.c sstore.c outbuf.c getvictron.c     *
+ *              -o getvictron                                   *
  * ------------------------------------------------------------ */
 #include <stdlib.h>
 #include <stdio.h>
@@ -21,15 +22,21 @@
 #include <string.h>
 #include <getopt.h>
 #include <time.h>
+#include "sstore.h"
+#include "outbuf.h"
 
 /* ------------------------------------------------------------ *
  * Global variables and defaults                                *
  * ------------------------------------------------------------ */
 int verbose = 0;                   // set when arg -v is given
 int outflag = 0;                   // set when arg -o is given
+int storeflag = 0;                 // set when arg -a is given
+int energyflag = 0;                // set when arg -e is given
 int retcode = 0;                   // return code of getvictron
 char device[255] = "/dev/ttyAMA0"; // cmdline arg -s overrides it
 char htmfile[255];                 // html output file and path
+char storebase[255];               // sample store base path
+char statefile[255];               // energy counter state file
 char serbuf[512];                  // serial line data buffer
 char blockbuf[256];                // one block of ve.direct data
 extern char *optarg;
@@ -69,6 +76,15 @@ struct fields bsolar[] = {
    {"Checksum","Checksum"}                 // 18
 };
 
+/* ------------------------------------------------------------ *
+ * Energy counters in Wh, integrated over the readings. They    *
+ * only increase, and are stored as RRD data sources so that    *
+ * the energy of any period is the difference of two values.   *
+ * ------------------------------------------------------------ */
+enum { E_PV, E_CHG, E_DIS, E_LOAD, E_COUNT };
+double energy[E_COUNT];            // epv, echg, edis, eload [Wh]
+#define E_MAXGAP 300               // sec, same as RRD heartbeat
+
 /* ------------------------------------------------------------ *
  * external function prototypes for sensor-type specific code   *
  * ------------------------------------------------------------ */
@@ -229,25 +245,25 @@ void convert_units(struct fields *list) {
    ptr->base = ptr->base / 1000;
 
    /* --------------------------------------------------------- *
-    * Convert Yield Total (H19) from kWh to Wh                  *
+    * Convert Yield Total (H19) from 0.01 kWh to Wh             *
     * --------------------------------------------------------- */
    ptr = list+7; // Yield Total list location
    ptr->base = atol(ptr->val);
-   ptr->base = ptr->base * 1000;
+   ptr->base = ptr->base * 10;
 
    /* --------------------------------------------------------- *
-    * Convert Yield Today (H20) from kWh to Wh                  *
+    * Convert Yield Today (H20) from 0.01 kWh to Wh             *
     * --------------------------------------------------------- */
    ptr = list+8; // Yield Today list location
    ptr->base = atol(ptr->val);
-   ptr->base = ptr->base * 1000;
+   ptr->base = ptr->base * 10;
 
    /* --------------------------------------------------------- *
-    * Convert Yield Yesterday (H20) from kWh to Wh              *
+    * Convert Yield Yesterday (H22) from 0.01 kWh to Wh         *
     * --------------------------------------------------------- */
    ptr = list+10; // Yield Yesterday list location
    ptr->base = atol(ptr->val);
-   ptr->base = ptr->base * 1000;
+   ptr->base = ptr->base * 10;
 
    /* --------------------------------------------------------- *
     * Convert Operational State code into Description String    * 
@@ -321,12 +337,11 @@ void convert_units(struct fields *list) {
  * ../install/rrdcreate.sh. String format is:  N:value[:value]  *
  * (see man rrdupdate). If there is no value output set to "U". *
  * ------------------------------------------------------------ */
-void create_rrdstr(struct fields *list, char *str) {
+void create_rrdstr(struct fields *list, char *str, time_t tsnow) {
    struct fields *ptr;
    /* --------------------------------------------------------- *
     * get the string components                                 *
     * --------------------------------------------------------- */
-   time_t tsnow = time(NULL);
    ptr = list+0; // Battery Voltage list location
    float vbat = ptr->base;
    ptr = list+3; // Battery Current list location
@@ -342,27 +357,156 @@ void create_rrdstr(struct fields *list, char *str) {
    /* --------------------------------------------------------- *
     * Combine, format and write the string per RRD schema order *
     *                                                           *
-    * pi-solar DB schema: timestamp:V:I:VPV:PPV:IL:CS:dayt-flag *
-    * e.g. 1522807566:12.3000:0.0210:15.0130:0.1450:0.2750:0:1  *
+    * pi-solar DB schema: timestamp:V:I:VPV:PPV:IL:CS:          *
+    *                     epv:echg:edis:eload:H19:H20:H22:dayt  *
+    * e.g. 1522807566:12.3000:0.0210:15.0130:0.1450:0.2750:0:   *
+    *      1520.3312:1012.0145:820.4410:301.2240:1510:40:50:1   *
     *                                                           *
     * The daytime flag is externally calculated and left out.   *
-    * Its added by the script solar-data.sh                     *
+    * Its added by the script solar-data.sh, which passes the   *
+    * DS order to rrdtool update with --template.               *
+    * --------------------------------------------------------- */
+   int len = snprintf(str, 255, "%lld:%.4f:%.4f:%.4f:%4f:%.4f:%.4f",
+                      (long long) tsnow, vbat, cbat, vpan, ppan, cload, opcs);
+   /* --------------------------------------------------------- *
+    * The energy counters follow: epv:echg:edis:eload, in Wh.   *
+    * Without arg -e they are unknown.                          *
     * --------------------------------------------------------- */
-   snprintf(str, 255, "%lld:%.4f:%.4f:%.4f:%4f:%.4f:%.4f",
-            (long long) tsnow, vbat, cbat, vpan, ppan, cload, opcs);
+   if(energyflag == 1)
+      len += snprintf(str+len, 255-len, ":%.4f:%.4f:%.4f:%.4f",
+               energy[E_PV], energy[E_CHG], energy[E_DIS], energy[E_LOAD]);
+   else
+      len += snprintf(str+len, 255-len, ":U:U:U:U");
+
+   /* --------------------------------------------------------- *
+    * The controller yield counters H19:H20:H22 follow, in Wh.  *
+    * Older firmware may not send them, then they are unknown.  *
+    * --------------------------------------------------------- */
+   int y;
+   for(y = 7; y <= 10; y++) {
+      if(y == 9) continue;   // skip H21 Maximum Power Today
+      ptr = list+y;
+      if(ptr->val[0] == '\0') len += snprintf(str+len, 255-len, ":U");
+      else len += snprintf(str+len, 255-len, ":%.0f", ptr->base);
+   }
 
    if(verbose == 1) printf("Debug: RRD update string creation complete.\n");
 }
 
+/* ------------------------------------------------------------ *
+ * integrate_energy() adds the energy since the last reading to *
+ * the counters. The previous reading and the counters are kept *
+ * in the state file, one line: ts vbat ibat ppv iload epv echg *
+ * edis eload. Each interval is integrated as a trapezoid, e.g. *
+ * (P1 + P2) / 2 * dt. Battery power V*I is split into charge   *
+ * (positive) and discharge (negative) energy. Intervals longer *
+ * than E_MAXGAP are skipped, we don't know what happened then. *
+ * A missing state file starts the counters at 0. solar-data.sh *
+ * seeds it from the last RRD values (ts 0, no last reading),   *
+ * so the counters continue. A state file we can't read is kept *
+ * as file.bad, and the counters restart at 0. pvpower sees the *
+ * drop as a counter reset, and uses the AVERAGE sums for cells *
+ * that span it. Errors go to stderr, stdout is the RRD update *
+ * string.                                                      *
+ * return code: 0 = success, -1 for errors                      *
+ * ------------------------------------------------------------ */
+int integrate_energy(struct fields *list, char *file, time_t tsnow) {
+   double now[4], last[4];
+   long long lastts = 0;
+   int i;
+
+   now[0] = list[0].base;   // Battery Voltage
+   now[1] = list[3].base;   // Battery Current
+   now[2] = list[2].base;   // Panel Power
+   now[3] = list[4].base;   // Load Current
+
+   FILE *fp = fopen(file, "r");
+   if(fp) {
+      if(fscanf(fp, "%lld %lf %lf %lf %lf %lf %lf %lf %lf", &lastts,
+                &last[0], &last[1], &last[2], &last[3], &energy[E_PV],
+                &energy[E_CHG], &energy[E_DIS], &energy[E_LOAD]) != 9) {
+         fprintf(stderr, "Error: cannot read energy state from %s, kept as .bad, "
+                 "counters restart.\n", file);
+         lastts = 0;
+         for(i = 0; i < E_COUNT; i++) energy[i] = 0.0;
+         char badfile[265];
+         snprintf(badfile, sizeof(badfile), "%s.bad", file);
+         rename(file, badfile);
+      }
+      fclose(fp);
+   }
+   else if(verbose == 1) printf("Debug: No energy state %s, counters start at 0.\n", file);
+
+   long dt = (long) (tsnow - lastts);
+   if(lastts > 0 && dt > 0 && dt <= E_MAXGAP) {
+      double pbat1 = last[0] * last[1];
+      double pbat2 = now[0] * now[1];
+      double hrs = dt / 3600.0;
+      energy[E_PV]   += (last[2] + now[2]) / 2 * hrs;
+      energy[E_CHG]  += ((pbat1 > 0 ? pbat1 : 0) + (pbat2 > 0 ? pbat2 : 0)) / 2 * hrs;
+      energy[E_DIS]  += ((pbat1 < 0 ? -pbat1 : 0) + (pbat2 < 0 ? -pbat2 : 0)) / 2 * hrs;
+      energy[E_LOAD] += (last[0] * last[3] + now[0] * now[3]) / 2 * hrs;
+   }
+   else if(verbose == 1) printf("Debug: No previous reading within %ds, counters unchanged.\n", E_MAXGAP);
+
+   /* --------------------------------------------------------- *
+    * Write the new state to a temp file, then rename it, so a  *
+    * power loss never leaves us with a half-written state.     *
+    * --------------------------------------------------------- */
+   char tmpfile[265];
+   snprintf(tmpfile, sizeof(tmpfile), "%s.tmp", file);
+   if(! (fp = fopen(tmpfile, "w"))) {
+      fprintf(stderr, "Error open %s for writing.\n", tmpfile);
+      return(-1);
+   }
+   fprintf(fp, "%lld %.4f %.4f %.4f %.4f %.6f %.6f %.6f %.6f\n", (long long) tsnow,
+           now[0], now[1], now[2], now[3], energy[E_PV], energy[E_CHG],
+           energy[E_DIS], energy[E_LOAD]);
+   fclose(fp);
+   if(rename(tmpfile, file) != 0) {
+      fprintf(stderr, "Error: cannot rename %s to %s.\n", tmpfile, file);
+      return(-1);
+   }
+   if(verbose == 1) printf("Debug: Energy counters [Wh] pv=%.4f chg=%.4f dis=%.4f load=%.4f\n",
+                           energy[E_PV], energy[E_CHG], energy[E_DIS], energy[E_LOAD]);
+   return(0);
+}
+
+/* ------------------------------------------------------------ *
+ * append_sample() adds the reading to the raw sample store. We *
+ * take the integer values as received (mV, mA, W) before the   *
+ * float conversion, so the stored history stays lossless.      *
+ * ------------------------------------------------------------ */
+int append_sample(struct fields *list, char *base, time_t tsnow) {
+   sstore ss;
+   ss_sample s;
+
+   s.ts = (int64_t) tsnow;
+   s.val[SS_VBAT] = atol(list[0].val);      // V   [mV]
+   s.val[SS_IBAT] = atol(list[3].val);      // I   [mA]
+   s.val[SS_VPNL] = atol(list[1].val);      // VPV [mV]
+   s.val[SS_PPNL] = atol(list[2].val);      // PPV [W]
+   s.val[SS_LOAD] = atol(list[4].val);      // IL  [mA]
+   s.val[SS_OPCS] = (int32_t) list[13].base; // CS, val holds the text
+
+   if(ss_open(&ss, base, 1) != 0) return(-1);
+   int ret = ss_append(&ss, &s);
+   ss_close(&ss);
+   if(verbose == 1) printf("Debug: Sample store [%s] append returned [%d]\n", base, ret);
+   return(ret);
+}
+
 /* ------------------------------------------------------------ *
  * print_usage() prints the programs commandline instructions.  *
  * ------------------------------------------------------------ */
 void usage() {
-   static char const usage[] = "Usage: getvictron -s [serial-tty] -o [html-output] [-v]\n\
+   static char const usage[] = "Usage: getvictron -s [serial-tty] -o [html-output] [-a store] [-e state] [-v]\n\
 \n\
 Command line parameters have the following format:\n\
    -s   serial line device, Examples: /dev/ttyS1, /dev/ttyAMA0\n\
    -o   optional, write sensor data to HTML file, Example: -o ./getsolar.htm\n\
+   -a   optional, append the reading to the raw sample store, Example: -a ../rrd/samples\n\
+   -e   optional, integrate the energy counters, keep state in file, Example: -e ../rrd/energy.dat\n\
    -h   optional, display this message\n\
    -v   optional, enables debug output\n\
 \n\
@@ -381,7 +525,7 @@ void parseargs(int argc, char* argv[]) {
 
    if(argc == 1) { usage(); exit(-1); }
 
-   while ((arg = (int) getopt (argc, argv, "s:o:vh")) != -1) {
+   while ((arg = (int) getopt (argc, argv, "s:o:a:e:vh")) != -1) {
       switch (arg) {
          // arg -s + serial device, type: string
          // mandatory, example: /dev/ttyAMA0
@@ -396,6 +540,20 @@ void parseargs(int argc, char* argv[]) {
             strncpy(htmfile, optarg, sizeof(htmfile));
             break;
 
+         // arg -a + sample store base name, type: string
+         // optional, example: /home/pi/pi-solar/rrd/samples
+         case 'a':
+            storeflag = 1;
+            strncpy(storebase, optarg, sizeof(storebase)-1);
+            break;
+
+         // arg -e + energy counter state file, type: string
+         // optional, example: /home/pi/pi-solar/rrd/energy.dat
+         case 'e':
+            energyflag = 1;
+            strncpy(statefile, optarg, sizeof(statefile)-1);
+            break;
+
          // arg -v verbose, type: flag, optional
          case 'v':
             verbose = 1; break;
@@ -424,81 +582,78 @@ void parseargs(int argc, char* argv[]) {
 
 void write_html(char *file, struct fields *list){
    /* -------------------------------------------------------- *
-    *  Open the html file for writing the table data           *
+    *  Render the html in memory, ob_write() puts it in place  *
     * -------------------------------------------------------- */
-   FILE *html;
-   if(! (html=fopen(file, "w"))) {
-      printf("Error open %s for writing.\n", htmfile);
-      exit(-1);
-   }
+   outbuf html = { 0 };
    if(verbose == 1) printf("Debug: Writing to file [%s]\n", file);
 
    /* -------------------------------------------------------- *
     *  Write the ve.direct data output table                   *
     * -------------------------------------------------------- */
    struct fields *ptr;
-   fprintf(html, "<table class=\"solartable\">\n");
+   ob_printf(&html, "<table class=\"solartable\">\n");
    ptr = list+15; // Product ID
-   fprintf(html, "<tr><th class=\"solarth\" rowspan=4>Charge Controller</th>");
-   fprintf(html, "<td class=\"solartd\"><div class=\"solarlbl\">%s</div>", ptr->lbl);
-   fprintf(html, "<div class=\"solarval\">%s</div></td></tr>\n", ptr->val);
+   ob_printf(&html, "<tr><th class=\"solarth\" rowspan=4>Charge Controller</th>");
+   ob_printf(&html, "<td class=\"solartd\"><div class=\"solarlbl\">%s</div>", ptr->lbl);
+   ob_printf(&html, "<div class=\"solarval\">%s</div></td></tr>\n", ptr->val);
    ptr = list+16; // Serial Number
-   fprintf(html, "<tr><td class=\"solartd\"><div class=\"solarlbl\">%s</div>", ptr->lbl);
-   fprintf(html, "<div class=\"solarval\">%s</div></td></tr>\n", ptr->val);
+   ob_printf(&html, "<tr><td class=\"solartd\"><div class=\"solarlbl\">%s</div>", ptr->lbl);
+   ob_printf(&html, "<div class=\"solarval\">%s</div></td></tr>\n", ptr->val);
    ptr = list+14; // Firmware Version
-   fprintf(html, "<tr><td class=\"solartd\"><div class=\"solarlbl\">%s</div>", ptr->lbl);
-   fprintf(html, "<div class=\"solarval\">%.2f</div></td></tr>\n", ptr->base);
+   ob_printf(&html, "<tr><td class=\"solartd\"><div class=\"solarlbl\">%s</div>", ptr->lbl);
+   ob_printf(&html, "<div class=\"solarval\">%.2f</div></td></tr>\n", ptr->base);
    ptr = list+13; // State of Operation CS
-   fprintf(html, "<tr><td class=\"solartd\"><div class=\"solarlbl\">%s</div>", ptr->lbl);
-   fprintf(html, "<div class=\"solarval\">%s</div></td></tr>\n", ptr->val);
+   ob_printf(&html, "<tr><td class=\"solartd\"><div class=\"solarlbl\">%s</div>", ptr->lbl);
+   ob_printf(&html, "<div class=\"solarval\">%s</div></td></tr>\n", ptr->val);
    ptr = list+0;  // Battery Voltage
-   fprintf(html, "<tr><th class=\"solarth\" rowspan=2>Battery</th>");
-   fprintf(html, "<td class=\"solartd\"><div class=\"solarlbl\">%s</div>", ptr->lbl);
-   fprintf(html, "<div class=\"solarval\">%.2f&thinsp;V</div></td></tr>\n", ptr->base);
+   ob_printf(&html, "<tr><th class=\"solarth\" rowspan=2>Battery</th>");
+   ob_printf(&html, "<td class=\"solartd\"><div class=\"solarlbl\">%s</div>", ptr->lbl);
+   ob_printf(&html, "<div class=\"solarval\">%.2f&thinsp;V</div></td></tr>\n", ptr->base);
    ptr = list+3;  // Battery Current
-   fprintf(html, "<tr><td class=\"solartd\"><div class=\"solarlbl\">%s</div>", ptr->lbl);
-   fprintf(html, "<div class=\"solarval\">%.2f&thinsp;A</div></td></tr>\n", ptr->base);
+   ob_printf(&html, "<tr><td class=\"solartd\"><div class=\"solarlbl\">%s</div>", ptr->lbl);
+   ob_printf(&html, "<div class=\"solarval\">%.2f&thinsp;A</div></td></tr>\n", ptr->base);
    ptr = list+1;  // Panel Voltage
-   fprintf(html, "<tr><th class=\"solarth\" rowspan=2>PV Panel</th>");
-   fprintf(html, "<td class=\"solartd\"><div class=\"solarlbl\">%s</div>", ptr->lbl);
-   fprintf(html, "<div class=\"solarval\">%.2f&thinsp;V</div></td></tr>\n", ptr->base);
+   ob_printf(&html, "<tr><th class=\"solarth\" rowspan=2>PV Panel</th>");
+   ob_printf(&html, "<td class=\"solartd\"><div class=\"solarlbl\">%s</div>", ptr->lbl);
+   ob_printf(&html, "<div class=\"solarval\">%.2f&thinsp;V</div></td></tr>\n", ptr->base);
    ptr = list+2;  // Panel Power
-   fprintf(html, "<tr><td class=\"solartd\"><div class=\"solarlbl\">%s</div>", ptr->lbl);
-   fprintf(html, "<div class=\"solarval\">%.2f&thinsp;W</div></td></tr>\n", ptr->base);
+   ob_printf(&html, "<tr><td class=\"solartd\"><div class=\"solarlbl\">%s</div>", ptr->lbl);
+   ob_printf(&html, "<div class=\"solarval\">%.2f&thinsp;W</div></td></tr>\n", ptr->base);
    ptr = list+5;  // Load Output State
-   fprintf(html, "<tr><th class=\"solarth\" rowspan=2>Load</th>");
-   fprintf(html, "<td class=solartd><div class=\"solarlbl\">%s</div>", ptr->lbl);
-   fprintf(html, "<div class=\"solarval\">%s</div></td></tr>\n", ptr->val);
+   ob_printf(&html, "<tr><th class=\"solarth\" rowspan=2>Load</th>");
+   ob_printf(&html, "<td class=solartd><div class=\"solarlbl\">%s</div>", ptr->lbl);
+   ob_printf(&html, "<div class=\"solarval\">%s</div></td></tr>\n", ptr->val);
    ptr = list+4;  // Load Current
-   fprintf(html, "<tr><td class=\"solartd\"><div class=\"solarlbl\">%s</div>", ptr->lbl);
-   fprintf(html, "<div class=\"solarval\">%.2f&thinsp;A</div></td></tr>\n", ptr->base);
-   fprintf(html, "</table>\n");
+   ob_printf(&html, "<tr><td class=\"solartd\"><div class=\"solarlbl\">%s</div>", ptr->lbl);
+   ob_printf(&html, "<div class=\"solarval\">%.2f&thinsp;A</div></td></tr>\n", ptr->base);
+   ob_printf(&html, "</table>\n");
 
    /* -------------------------------------------------------- *
     *  Write the power balance output table                    *
     * -------------------------------------------------------- */
-   fprintf(html, "<hr />\n");
-   fprintf(html, "<table><tr>\n");
+   ob_printf(&html, "<hr />\n");
+   ob_printf(&html, "<table><tr>\n");
    ptr = list+2;  // Panel Power
-   fprintf(html, "<td class=\"sensordata\">Solar Power IN:");
-   fprintf(html, "<span class=\"sensorvalue\">%.2f&thinsp;W</span></td>\n", ptr->base);
-   fprintf(html, "<td class=\"sensorspace\"></td>\n");
+   ob_printf(&html, "<td class=\"sensordata\">Solar Power IN:");
+   ob_printf(&html, "<span class=\"sensorvalue\">%.2f&thinsp;W</span></td>\n", ptr->base);
+   ob_printf(&html, "<td class=\"sensorspace\"></td>\n");
    ptr = list+0;  // Panel Power
    float vbat = ptr->base;
    ptr = list+3;  // Panel Power
    float ibat = ptr->base;
    float pbat = vbat * ibat;
-   fprintf(html, "<td class=\"sensordata\">Power Balance +/-:");
-   fprintf(html, "<span class=\"sensorvalue\">%+.2f&thinsp;W</span></td>\n", pbat);
-   fprintf(html, "<td class=\"sensorspace\"></td>\n");
+   ob_printf(&html, "<td class=\"sensordata\">Power Balance +/-:");
+   ob_printf(&html, "<span class=\"sensorvalue\">%+.2f&thinsp;W</span></td>\n", pbat);
+   ob_printf(&html, "<td class=\"sensorspace\"></td>\n");
    ptr = list+4;  // Load Current
    float pload = vbat * ptr->base;
-   fprintf(html, "<td class=\"sensordata\">Load Power OUT:");
-   fprintf(html, "<span class=\"sensorvalue\">%.2f&thinsp;W</span></td>\n", pload);
-   fprintf(html, "</tr></table>\n");
+   ob_printf(&html, "<td class=\"sensordata\">Load Power OUT:");
+   ob_printf(&html, "<span class=\"sensorvalue\">%.2f&thinsp;W</span></td>\n", pload);
+   ob_printf(&html, "</tr></table>\n");
 
+   if(ob_write(&html, file) != 0) exit(-1);
+   ob_free(&html);
    if(verbose == 1) printf("Debug: Finished writing to file [%s]\n", file);
-   fclose(html);
 }
 
 int main(int argc, char *argv[]) {
@@ -571,15 +726,26 @@ int main(int argc, char *argv[]) {
 
    /* -------------------------------------------------------- *
     * Converts received unit values into base SI units, e.g.   *
-    * mV->Volt, mA->A, kWh -> Wh, with 0.4 digits precision.   *
+    * mV->Volt, mA->A, 0.01kWh->Wh, with 0.4 digits precision. *
     * -------------------------------------------------------- */
    convert_units(bsolar);
 
+   /* -------------------------------------------------------- *
+    * The time of the reading, the same for the RRD string,    *
+    * the energy counters and the sample store.                *
+    * -------------------------------------------------------- */
+   tsnow = time(NULL);
+
+   /* -------------------------------------------------------- *
+    * with arg -e, add this reading to the energy counters     *
+    * -------------------------------------------------------- */
+   if(energyflag == 1 && integrate_energy(bsolar, statefile, tsnow) != 0) energyflag = 0;
+
    /* -------------------------------------------------------- *
     * Create RRD database update string from serial block data *
     * -------------------------------------------------------- */
    char rrdstr[255];
-   create_rrdstr(bsolar, rrdstr);
+   create_rrdstr(bsolar, rrdstr, tsnow);
    if(verbose == 1) printf("Debug: RRD update string [%s]\n", rrdstr);
    printf("%s\n", rrdstr);
 
@@ -588,5 +754,10 @@ int main(int argc, char *argv[]) {
     * -------------------------------------------------------- */
    if(outflag == 1) write_html(htmfile, bsolar);
 
+   /* -------------------------------------------------------- *
+    * with arg -a, append the reading to the raw sample store  *
+    * -------------------------------------------------------- */
+   if(storeflag == 1) append_sample(bsolar, storebase, tsnow);
+
    exit(retcode);
 }
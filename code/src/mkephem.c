@@ -0,0 +1,317 @@
+/* ------------------------------------------------------------ *
+ * file:        mkephem.c                                       *
+ * purpose:     Create the sun position table of the site for   *
+ *              getspa -e, see ephem.h. With -q, look up a      *
+ *              timestamp in an existing table instead.         *
+ *                                                              *
+ * author:      10/18/2026 agent                                *
+ *                                                              *
+ * compile:     gcc spa.c ephem.c mkephem.c -o mkephem -lm      *
+ *                                                              *
+ * The table starts at local midnight of January 1st of the     *
+ * year, and covers two years by default. Recreated once a year *
+ * it always holds the current date. Elevation, panel slope and *
+ * rotation come from the options, make ephem passes them from  *
+ * pi-solar.conf. The other SPA values are the ones of getspa.  *
+ * ------------------------------------------------------------ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include <unistd.h>
+#include <time.h>
+#include "spa.h"
+#include "ephem.h"
+
+/* ------------------------------------------------------------ *
+ * Global variables and defaults                                *
+ * ------------------------------------------------------------ */
+int verbose = 0;
+int queryflag = 0;                  // set when arg -q is given
+time_t query_t = 0;
+double latitude = 0;
+double longitude = 0;
+int tzflag = 0;                     // set when arg -z is given
+long tzoffset = 0;
+int year = 0;
+int days = 0;
+int step = 60;
+double elevation = 0;               // meters, arg -e
+double azm_rotation = 0;            // panel offset from south, arg -a
+double slope = 0;                   // panel tilt, arg -t
+char tblfile[1024] = "";
+
+extern char *optarg;
+extern int optind, opterr, optopt;
+
+/* ------------------------------------------------------------ *
+ * print_usage() prints the programs commandline instructions.  *
+ * ------------------------------------------------------------ */
+void usage() {
+   static char const usage[] = "Usage: mkephem -x longitude -y latitude [-s timezone] [-d year] [-n days] [-r step] [-e elevation] [-a rotation] [-t slope] -f tablefile [-v]\n\
+       mkephem -q timestamp -f tablefile\n\n\
+Command line parameters have the following format:\n\
+   -x   longitude, example: 12.45277778\n\
+   -y   latitude, example: 51.340277778\n\
+   -z   timezone offset in hrs, example: 9, optional, defaults to local system timezone offset\n\
+   -s   timezone name, example: \"Europe/Berlin\", optional, prefered instead of -z option\n\
+   -d   first year of the table, example: 2026, optional, defaults to the current year\n\
+   -n   number of days, optional, defaults to two years\n\
+   -r   seconds between samples, must divide a day, optional, defaults to 60\n\
+   -e   site elevation in meters, example: 35, optional, defaults to 0\n\
+   -a   panel azimuth rotation from south in degrees, example: -10, optional, defaults to 0\n\
+   -t   panel slope from horizontal in degrees, example: 30, optional, defaults to 0\n\
+   -f   table file name\n\
+   -q   Unix timestamp, look it up in the table file\n\
+   -v   verbose output flag\n\
+   -h   print usage flag\n\n\
+Usage example:\n\
+./mkephem -x 139.628999 -y 35.610381 -s Asia/Tokyo -e 35 -a -10 -f /home/pi/pi-solar/rrd/ephem.tbl\n";
+   printf(usage);
+}
+
+/* ------------------------------------------------------------ *
+ * parseargs() checks the commandline arguments with C getopt   *
+ * ------------------------------------------------------------ */
+void parseargs(int argc, char* argv[]) {
+   int arg;
+   char *end;
+   opterr = 0;
+
+   if(argc == 1) { usage(); exit(-1); }
+
+   while ((arg = (int) getopt (argc, argv, "x:y:z:s:d:n:r:e:a:t:f:q:vh")) != -1)
+      switch (arg) {
+         // arg -x longitude, type: double, example: 12.45277777777777
+         case 'x':
+            longitude = strtod(optarg, &end);
+            if(end == optarg || longitude < -180.0 || longitude > 180.0) {
+               printf("Error: Cannot get valid -x longitude argument.\n");
+               exit(-1);
+            }
+            break;
+
+         // arg -y latitude, type: double, example: 51.34027777777778
+         case 'y':
+            latitude = strtod(optarg, &end);
+            if(end == optarg || latitude < -90.0 || latitude > 90.0) {
+               printf("Error: Cannot get valid -y latitude argument.\n");
+               exit(-1);
+            }
+            break;
+
+         // arg -z timezone, type: integer, example: 9
+         // optional, defaults to the system timezone
+         case 'z':
+            tzoffset = strtol(optarg, NULL, 10);
+            if (tzoffset < -11 || tzoffset > 11) {
+               printf("Error: Cannot get valid -z timezone offset argument.\n");
+               exit(-1);
+            }
+            tzoffset = tzoffset*3600;
+            tzflag = 1;
+            break;
+
+         // arg -s timezone name, type: string, example: "Europe/Berlin"
+         // optional, defaults to system time zone
+         case 's':
+            setenv("TZ", optarg, 1);
+            tzset();
+            break;
+
+         // arg -d year, type: integer, example: 2026
+         // optional, defaults to the current year
+         case 'd':
+            year = atoi(optarg);
+            if(year < 1971 || year > 2999) {
+               printf("Error: Cannot get valid -d year argument.\n");
+               exit(-1);
+            }
+            break;
+
+         // arg -n days, type: integer, example: 365
+         // optional, defaults to two years
+         case 'n':
+            days = atoi(optarg);
+            if(days < 1 || days > 3660) {
+               printf("Error: Cannot get valid -n days argument (1..3660).\n");
+               exit(-1);
+            }
+            break;
+
+         // arg -r step, type: integer, example: 60
+         // optional, defaults to 60
+         case 'r':
+            step = atoi(optarg);
+            if(step < 1 || 86400 % step != 0) {
+               printf("Error: -r step %s must divide a day (86400s).\n", optarg);
+               exit(-1);
+            }
+            break;
+
+         // arg -e elevation, type: double, example: 35
+         // optional, defaults to 0
+         case 'e':
+            elevation = strtod(optarg, &end);
+            if(end == optarg || elevation < -500.0 || elevation > 9000.0) {
+               printf("Error: Cannot get valid -e elevation argument.\n");
+               exit(-1);
+            }
+            break;
+
+         // arg -a azimuth rotation, type: double, example: -10
+         // optional, defaults to 0
+         case 'a':
+            azm_rotation = strtod(optarg, &end);
+            if(end == optarg || azm_rotation < -360.0 || azm_rotation > 360.0) {
+               printf("Error: Cannot get valid -a rotation argument.\n");
+               exit(-1);
+            }
+            break;
+
+         // arg -t slope, type: double, example: 30
+         // optional, defaults to 0
+         case 't':
+            slope = strtod(optarg, &end);
+            if(end == optarg || slope < -360.0 || slope > 360.0) {
+               printf("Error: Cannot get valid -t slope argument.\n");
+               exit(-1);
+            }
+            break;
+
+         // arg -f table file name, type: string, example: "/home/pi/pi-solar/rrd/ephem.tbl"
+         case 'f':
+            strncpy(tblfile, optarg, sizeof(tblfile)-1);
+            break;
+
+         // arg -q timestamp, type: time_t, example: 1486784589
+         case 'q':
+            query_t = (time_t) atoll(optarg);
+            queryflag = 1;
+            break;
+
+         // arg -v verbose, type: flag, optional
+         case 'v':
+            verbose = 1; break;
+
+         // arg -h usage, type: flag, optional
+         case 'h':
+            usage(); exit(0);
+
+         case '?':
+            if (isprint (optopt))
+               printf ("Error: Unknown option `-%c'.\n", optopt);
+            else
+               printf ("Error: Unknown option character `\\x%x'.\n", optopt);
+
+         default:
+            usage();
+            exit(-1);
+    }
+    if(tblfile[0] == '\0') {
+       printf("Error: missing table file argument -f.\n");
+       exit(-1);
+    }
+}
+
+/* ------------------------------------------------------------ *
+ * query_table() prints the table values for query_t, the time  *
+ * values as local time.                                        *
+ * ------------------------------------------------------------ */
+int query_table() {
+   ephem ep;
+   ep_pos pos;
+   int64_t *rts[3] = { &pos.sunrise, &pos.suntransit, &pos.sunset };
+   const char *rtsname[3] = { "Sunrise", "Transit", "Sunset" };
+
+   if(ep_open(&ep, tblfile) != 0) return(-1);
+   if(verbose == 1) {
+      printf("Table site:    %.6f %.6f, timezone %.1f\n", ep.hdr->latitude,
+             ep.hdr->longitude, ep.hdr->timezone);
+      printf("Table range:   %lld + %u days, step %us\n", (long long) ep.hdr->start,
+             ep.hdr->days, ep.hdr->step);
+   }
+   /* the local offset at query_t picks the day, incl. DST */
+   struct tm qtm;
+   localtime_r(&query_t, &qtm);
+   if(ep_lookup(&ep, query_t, tzflag ? tzoffset : qtm.tm_gmtoff, &pos) != 0) {
+      printf("Error: timestamp %lld is outside of table %s.\n", (long long) query_t, tblfile);
+      ep_close(&ep);
+      return(-1);
+   }
+   if(verbose == 1) {
+      printf("Zenith:        %.6f degrees\n", pos.zenith);
+      printf("Azimuth:       %.6f degrees\n", pos.azimuth);
+      printf("Incidence:     %.6f degrees\n", pos.incidence);
+      for(int i = 0; i < 3; i++) {
+         if(*rts[i] == EP_NONE) { printf("%-14s none\n", rtsname[i]); continue; }
+         time_t t = (time_t) *rts[i];
+         struct tm tm;
+         localtime_r(&t, &tm);
+         printf("%s:%*s%02d:%02d:%02d Local Time\n", rtsname[i], (int) (14 - strlen(rtsname[i])),
+                "", tm.tm_hour, tm.tm_min, tm.tm_sec);
+      }
+   }
+   // same format as getspa: 1531641966:116.604309:78.838956
+   printf("%lld:%.6f:%.6f\n", (long long) query_t, pos.zenith, pos.azimuth);
+   ep_close(&ep);
+   return(0);
+}
+
+int main (int argc, char *argv[]) {
+
+   parseargs(argc, argv);
+   if(queryflag == 1) exit(query_table());
+
+   /* ------------------------------------------------------------ *
+    * The table starts at local midnight of January 1st. Days are  *
+    * kept in the standard time of the zone (its January offset).  *
+    * ------------------------------------------------------------ */
+   time_t now = time(NULL);
+   struct tm tm = {0};
+   localtime_r(&now, &tm);
+   if(year == 0) year = tm.tm_year + 1900;
+
+   memset(&tm, 0, sizeof(tm));
+   tm.tm_year = year - 1900;
+   tm.tm_mday = 1;
+   tm.tm_hour = 12;
+   tm.tm_isdst = -1;
+   time_t jan1 = mktime(&tm);
+   if(tzflag == 0) tzoffset = tm.tm_gmtoff;
+   time_t start = (jan1 + tzoffset) / 86400 * 86400 - tzoffset;
+
+   if(days == 0) {
+      memset(&tm, 0, sizeof(tm));
+      tm.tm_year = year + 2 - 1900;
+      tm.tm_mday = 1;
+      tm.tm_hour = 12;
+      tm.tm_isdst = -1;
+      days = (mktime(&tm) - jan1 + 43200) / 86400;
+   }
+
+   spa_data spa;
+   memset(&spa, 0, sizeof(spa));
+   spa.timezone      = tzoffset / 3600.0;
+   spa.delta_ut1     = 0;
+   spa.delta_t       = 67;
+   spa.longitude     = longitude;
+   spa.latitude      = latitude;
+   spa.elevation     = elevation;
+   spa.pressure      = 1005;
+   spa.temperature   = 16;
+   spa.slope         = slope;
+   spa.azm_rotation  = azm_rotation;
+   spa.atmos_refract = 0.5667;
+   spa.function      = SPA_ALL;
+
+   if(verbose == 1) {
+      printf("Site:          %.6f %.6f, timezone %.1f\n", latitude, longitude, spa.timezone);
+      printf("Table start:   %lld (%d-01-01 00:00 local)\n", (long long) start, year);
+      printf("Table size:    %d days, step %ds\n", days, step);
+      printf("Panel:         elevation %.2fm, slope %.2f, rotation %.2f\n", elevation, slope, azm_rotation);
+   }
+   if(ep_create(tblfile, &spa, start, days, step) != 0) exit(-1);
+   if(verbose == 1) printf("Table written: %s\n", tblfile);
+   return(0);
+}
@@ -0,0 +1,127 @@
+/* ------------------------------------------------------------ *
+ * file:        outbuf.c                                        *
+ * purpose:     Buffered writer for the generated output files, *
+ *              see outbuf.h.                                   *
+ *                                                              *
+ * author:      10/18/2026 agent                                *
+ * ------------------------------------------------------------ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdarg.h>
+#include <string.h>
+#include <utime.h>
+#include "outbuf.h"
+
+/* ------------------------------------------------------------ *
+ * ob_grow() makes room for need more bytes plus the 0 byte of  *
+ * vsnprintf(). The size doubles, a table file needs a few KB.  *
+ * ------------------------------------------------------------ */
+static int ob_grow(outbuf *ob, size_t need) {
+   if(ob->len + need + 1 <= ob->size) return(0);
+   size_t size = (ob->size == 0) ? 4096 : ob->size;
+   while(ob->len + need + 1 > size) size = size * 2;
+   char *data = realloc(ob->data, size);
+   if(data == NULL) {
+      ob->failed = 1;
+      return(-1);
+   }
+   ob->data = data;
+   ob->size = size;
+   return(0);
+}
+
+int ob_printf(outbuf *ob, const char *fmt, ...) {
+   va_list ap;
+
+   if(ob->failed == 1) return(-1);
+   if(ob_grow(ob, 256) != 0) return(-1);
+
+   va_start(ap, fmt);
+   int n = vsnprintf(ob->data + ob->len, ob->size - ob->len, fmt, ap);
+   va_end(ap);
+   if(n < 0) {
+      ob->failed = 1;
+      return(-1);
+   }
+   /* ------------------------------------------------------------ *
+    * Long text didn't fit, grow to its length and print again.    *
+    * ------------------------------------------------------------ */
+   if(ob->len + n + 1 > ob->size) {
+      if(ob_grow(ob, n) != 0) return(-1);
+      va_start(ap, fmt);
+      vsnprintf(ob->data + ob->len, ob->size - ob->len, fmt, ap);
+      va_end(ap);
+   }
+   ob->len = ob->len + n;
+   return(0);
+}
+
+/* ------------------------------------------------------------ *
+ * ob_same() returns 1 if file holds exactly the buffer text.   *
+ * ------------------------------------------------------------ */
+static int ob_same(const outbuf *ob, const char *file) {
+   char chunk[4096];
+   size_t pos = 0, n;
+   int same = 1;
+
+   FILE *fp = fopen(file, "r");
+   if(! fp) return(0);
+   while(same == 1 && (n = fread(chunk, 1, sizeof(chunk), fp)) > 0) {
+      if(pos + n > ob->len || memcmp(ob->data + pos, chunk, n) != 0) same = 0;
+      pos = pos + n;
+   }
+   if(ferror(fp) || pos != ob->len) same = 0;
+   fclose(fp);
+   return(same);
+}
+
+int ob_write(const outbuf *ob, const char *file) {
+   if(ob->failed == 1) {
+      printf("Error: out of memory creating %s.\n", file);
+      return(-1);
+   }
+   /* ------------------------------------------------------------ *
+    * Same content: only set the modification time, the web pages *
+    * show it as the time of the last update (solar.php).          *
+    * ------------------------------------------------------------ */
+   if(ob_same(ob, file) == 1 && utime(file, NULL) == 0) return(0);
+
+   /* ------------------------------------------------------------ *
+    * Write a temp file next to it, then rename() it into place.   *
+    * ------------------------------------------------------------ */
+   char tmpfile[4096];
+   if(snprintf(tmpfile, sizeof(tmpfile), "%s.tmp", file) >= (int) sizeof(tmpfile)) {
+      printf("Error: file name %s is too long.\n", file);
+      return(-1);
+   }
+   FILE *fp = fopen(tmpfile, "w");
+   if(! fp) {
+      printf("Error open %s for writing.\n", tmpfile);
+      return(-1);
+   }
+   size_t n = fwrite(ob->data, 1, ob->len, fp);
+   if(fclose(fp) != 0 || n != ob->len) {
+      printf("Error writing %s.\n", tmpfile);
+      remove(tmpfile);
+      return(-1);
+   }
+   if(rename(tmpfile, file) != 0) {
+      printf("Error: cannot rename %s to %s.\n", tmpfile, file);
+      remove(tmpfile);
+      return(-1);
+   }
+   return(0);
+}
+
+void ob_clear(outbuf *ob) {
+   ob->len = 0;
+   ob->failed = 0;
+}
+
+void ob_free(outbuf *ob) {
+   free(ob->data);
+   ob->data = NULL;
+   ob->len = 0;
+   ob->size = 0;
+   ob->failed = 0;
+}
@@ -0,0 +1,49 @@
+/* ------------------------------------------------------------ *
+ * file:        outbuf.h                                        *
+ * purpose:     Buffered writer for the generated output files. *
+ *                                                              *
+ * author:      10/18/2026 agent                                *
+ *                                                              *
+ * The output files are built in memory with ob_printf(), and   *
+ * ob_write() puts them in place with a temp file and rename(). *
+ * A PHP page including them never sees a half written file,    *
+ * and the SD card gets one write instead of one per table cell *
+ * or none at all, if the content did not change. An outbuf     *
+ * keeps its memory, ob_clear() readies it for the next file.   *
+ * ------------------------------------------------------------ */
+#ifndef OUTBUF_H
+#define OUTBUF_H
+
+#include <stddef.h>
+
+typedef struct {
+   char *data;                 // the text, not 0-terminated
+   size_t len;                 // bytes used
+   size_t size;                // bytes allocated
+   int failed;                 // set if an allocation failed
+} outbuf;
+
+/* ------------------------------------------------------------ *
+ * ob_printf() appends printf-style text to the buffer. If the  *
+ * buffer can't grow, the text is dropped and ob->failed is set *
+ * so ob_write() refuses to write a truncated file.             *
+ * return code: 0 = success, -1 if out of memory                *
+ * ------------------------------------------------------------ */
+int ob_printf(outbuf *ob, const char *fmt, ...)
+    __attribute__((format(printf, 2, 3)));
+
+/* ------------------------------------------------------------ *
+ * ob_write() replaces file with the buffer content. It writes  *
+ * file.tmp and renames it. If file holds the same bytes, only  *
+ * its modification time is set to now.                         *
+ * return code: 0 = success, -1 on error (message is printed)   *
+ * ------------------------------------------------------------ */
+int ob_write(const outbuf *ob, const char *file);
+
+/* ------------------------------------------------------------ *
+ * ob_clear() empties the buffer, ob_free() releases it.        *
+ * ------------------------------------------------------------ */
+void ob_clear(outbuf *ob);
+void ob_free(outbuf *ob);
+
+#endif
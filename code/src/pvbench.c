@@ -0,0 +1,443 @@
+/* ------------------------------------------------------------ *
+ * file:        pvbench.c                                       *
+ * purpose:     Benchmark pvpower over synthetic solar RRDs of  *
+ *              1, 5 and 18 years. Creates the RRDs with the    *
+ *              install/rrdcreate.sh schema, fills them from a  *
+ *              solar-like generator, runs each report mode of  *
+ *              pvpower with -T, and prints the median phase    *
+ *              times as CSV to stdout.                         *
+ *                                                              *
+ * author:      10/18/2026 agent                                *
+ *                                                              *
+ * compile:     gcc pvbench.c -o pvbench -lrrd -lm              *
+ *                                                              *
+ * The RRDs are kept in the work directory (-w) and reused by   *
+ * the next run, unless they are older than a day: the reports  *
+ * end at "now", so a stale RRD would time empty columns. The   *
+ * generator writes one update per 5 minutes (the DS heartbeat) *
+ * and per minute for the last 14 days, the range of the minute *
+ * RRA, so 18 years take ~1.9 million updates.                  *
+ *                                                              *
+ * The CSV columns are: years, report, mode, runs, then the     *
+ * median seconds over the runs of wall (pvpower start to end), *
+ * fetch, reduce, render and write (summed over the tables),    *
+ * and the fetched rows. The columns and their order are fixed, *
+ * new ones get appended at the end.                            *
+ * ------------------------------------------------------------ */
+#define _XOPEN_SOURCE 700   // for realpath()
+#define _DEFAULT_SOURCE 1
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <ctype.h>
+#include <unistd.h>
+#include <time.h>
+#include <math.h>
+#include <limits.h>
+#include <sys/stat.h>
+#include <rrd.h>
+
+/* ------------------------------------------------------------ *
+ * Global variables and defaults                                *
+ * ------------------------------------------------------------ */
+int verbose = 0;
+int runs = 5;                      // timed runs per mode, see -n
+int years[8] = { 1, 5, 18 };       // RRD sizes, see -y
+int nyears = 3;
+char pvpower[PATH_MAX] = "./pvpower"; // program to time, see -p
+char workdir[PATH_MAX] = "/tmp/pvbench"; // RRDs and output files, see -w
+char outfmt[8] = "html";           // pvpower output format, see -o
+extern char *optarg;
+extern int optind, opterr, optopt;
+
+/* ------------------------------------------------------------ *
+ * The RRD schema of install/rrdcreate.sh, keep them the same.  *
+ * ------------------------------------------------------------ */
+static const char *rrd_schema[] = {
+   "DS:vbat:GAUGE:300:-50:50",   "DS:ibat:GAUGE:300:-100:100",
+   "DS:vpnl:GAUGE:300:-150:150", "DS:ppnl:GAUGE:300:0:1000",
+   "DS:load:GAUGE:300:0:100",    "DS:opcs:GAUGE:300:0:5",
+   "DS:dayt:GAUGE:300:0:1",      "DS:epv:GAUGE:300:0:U",
+   "DS:echg:GAUGE:300:0:U",      "DS:edis:GAUGE:300:0:U",
+   "DS:eload:GAUGE:300:0:U",     "DS:yldt:GAUGE:300:0:U",
+   "DS:yldd:GAUGE:300:0:U",      "DS:ylds:GAUGE:300:0:U",
+   "RRA:AVERAGE:0.5:1:20160",    "RRA:AVERAGE:0.5:60:13200",
+   "RRA:AVERAGE:0.5:1440:6580",  "RRA:MIN:0.5:60:13200",
+   "RRA:MAX:0.5:60:13200",       "RRA:MIN:0.5:1440:6580",
+   "RRA:MAX:0.5:1440:6580",
+};
+
+/* ------------------------------------------------------------ *
+ * The benchmark modes, the pvpower arguments of each. The      *
+ * output files are relative to the work directory. %s is the   *
+ * report start for -f, the first day of the RRD. cold removes  *
+ * the daily totals cache before each run, warm fills it once   *
+ * before the timed runs.                                       *
+ * ------------------------------------------------------------ */
+enum { C_NONE, C_COLD, C_WARM };
+struct mode {
+   const char *name;
+   const char *args;
+   int cache;                      // C_NONE etc.
+   int minmax;                     // set if the mode has a minmax report
+};
+static const struct mode modes[] = {
+   { "day",         "-d day.out", C_NONE, 1 },
+   { "month",       "-m month.out", C_NONE, 1 },
+   { "year",        "-y year.out", C_NONE, 1 },
+   { "all",         "-d day.out -m month.out -y year.out", C_NONE, 1 },
+   { "cache-cold",  "-c cache.dat -d day.out -m month.out -y year.out", C_COLD, 0 },
+   { "cache-warm",  "-c cache.dat -d day.out -m month.out -y year.out", C_WARM, 0 },
+   { "range-day",   "-q range.out -f %s -g day", C_NONE, 1 },
+   { "range-month", "-q range.out -f %s -g month", C_NONE, 1 },
+};
+
+enum { B_WALL, B_FETCH, B_REDUCE, B_RENDER, B_WRITE, B_ROWS, B_COUNT };
+
+/* ------------------------------------------------------------ *
+ * print_usage() prints the programs commandline instructions.  *
+ * ------------------------------------------------------------ */
+void usage() {
+   static char const usage[] = "Usage: pvbench [-p pvpower] [-w workdir] [-y years] [-n runs] [-o html|csv|json] [-v]\n\
+\n\
+Command line parameters have the following format:\n\
+   -p   optional, pvpower program to benchmark, default: ./pvpower\n\
+   -w   optional, work directory for the RRDs and output files, default: /tmp/pvbench\n\
+   -y   optional, comma separated RRD sizes in years, 1..18, default: 1,5,18\n\
+   -n   optional, timed runs per mode, the median is reported, default: 5\n\
+   -o   optional, pvpower output format html (default), csv or json\n\
+   -h   optional, display this message\n\
+   -v   optional, enables debug output\n\
+\n\
+Usage examples:\n\
+./pvbench -p ./pvpower > bench.csv\n\
+./pvbench -p ./pvpower -y 18 -n 3 -o json\n";
+   printf(usage);
+}
+
+/* ------------------------------------------------------------ *
+ * parseargs() checks the commandline arguments with C getopt   *
+ * ------------------------------------------------------------ */
+void parseargs(int argc, char* argv[]) {
+   int arg;
+   char *tok;
+   opterr = 0;
+
+   while ((arg = (int) getopt (argc, argv, "p:w:y:n:o:vh")) != -1)
+      switch (arg) {
+         // arg -p + pvpower program, type: string
+         // optional, example: ./pvpower
+         case 'p':
+            if(verbose == 1) printf("Debug: arg -p, value %s\n", optarg);
+            strncpy(pvpower, optarg, sizeof(pvpower) - 1);
+            break;
+
+         // arg -w + work directory, type: string
+         // optional, example: /tmp/pvbench
+         case 'w':
+            if(verbose == 1) printf("Debug: arg -w, value %s\n", optarg);
+            strncpy(workdir, optarg, sizeof(workdir) - 1);
+            break;
+
+         // arg -y + RRD sizes in years, type: comma separated list
+         // optional, example: 1,5,18
+         case 'y':
+            if(verbose == 1) printf("Debug: arg -y, value %s\n", optarg);
+            nyears = 0;
+            for(tok = strtok(optarg, ","); tok != NULL; tok = strtok(NULL, ",")) {
+               if(nyears == 8 || atoi(tok) < 1 || atoi(tok) > 18) {
+                  printf("Error: Cannot get valid -y years argument [%s].\n", tok);
+                  exit(-1);
+               }
+               years[nyears++] = atoi(tok);
+            }
+            break;
+
+         // arg -n + number of runs, type: integer
+         // optional, example: 5
+         case 'n':
+            if(verbose == 1) printf("Debug: arg -n, value %s\n", optarg);
+            runs = atoi(optarg);
+            if(runs < 1 || runs > 100) {
+               printf("Error: Cannot get valid -n runs argument, use 1..100.\n");
+               exit(-1);
+            }
+            break;
+
+         // arg -o + output format, type: string
+         // optional, html, csv or json, default: html
+         case 'o':
+            if(verbose == 1) printf("Debug: arg -o, value %s\n", optarg);
+            if(strcmp(optarg, "html") != 0 && strcmp(optarg, "csv") != 0 && strcmp(optarg, "json") != 0) {
+               printf("Error: Unknown output format `%s', use html, csv or json.\n", optarg);
+               exit(-1);
+            }
+            strcpy(outfmt, optarg);
+            break;
+
+         // arg -v verbose, type: flag, optional
+         case 'v':
+            verbose = 1; break;
+
+         // arg -h usage, type: flag, optional
+         case 'h':
+            usage(); exit(0);
+
+         case '?':
+            if(isprint (optopt))
+               printf ("Error: Unknown option `-%c'.\n", optopt);
+            else
+               printf ("Error: Unknown option character `\\x%x'.\n", optopt);
+            usage();
+            exit(-1);
+    }
+    if(nyears == 0) {
+       printf("Error: Cannot get valid -y years argument.\n");
+       exit(-1);
+    }
+}
+
+/* ------------------------------------------------------------ *
+ * The generator keeps the state of the simulated system: a     *
+ * 300 W panel at 35.7N 139.7E, a 100 Ah 12 V battery and a     *
+ * load of 1 A, 1.5 A in the evening. Each local day gets a     *
+ * cloud factor from a fixed pseudo-random sequence, so the     *
+ * same RRD comes out on every run. The counters work like the  *
+ * getvictron -e energy counters and the controller yields.     *
+ * ------------------------------------------------------------ */
+#define GEN_LAT 35.7
+#define GEN_LON 139.7
+#define GEN_PANEL 300.0            // panel peak power [W]
+#define GEN_CAPACITY 1200.0        // battery capacity [Wh]
+struct gen {
+   double soc;                     // battery state of charge 0..1
+   double epv, echg, edis, eload;  // energy counters [Wh]
+   double yday, ylast;             // yield of today and yesterday [Wh]
+   int daykey;                     // local date of yday, YYYYMMDD
+   double cloud;                   // cloud factor of today
+   unsigned int seed;              // state of the cloud sequence
+};
+
+/* ------------------------------------------------------------ *
+ * sun_height() returns the sine of the solar elevation at t,   *
+ * from the declination and the hour angle. This is good to a   *
+ * degree or so, plenty for synthetic data.                     *
+ * ------------------------------------------------------------ */
+double sun_height(time_t t) {
+   struct tm utc;
+   gmtime_r(&t, &utc);
+   double decl = -23.44 * cos(2 * M_PI * (utc.tm_yday + 10) / 365.0) * M_PI / 180;
+   double hrs = utc.tm_hour + utc.tm_min / 60.0 + GEN_LON / 15.0;
+   double hangle = (hrs - 12.0) * 15.0 * M_PI / 180;
+   double lat = GEN_LAT * M_PI / 180;
+   return(sin(lat) * sin(decl) + cos(lat) * cos(decl) * cos(hangle));
+}
+
+/* ------------------------------------------------------------ *
+ * gen_sample() advances the generator by dt seconds to t, and  *
+ * writes the RRD update string for t into buf.                 *
+ * ------------------------------------------------------------ */
+void gen_sample(struct gen *g, time_t t, long dt, char *buf, size_t len) {
+   struct tm local;
+   localtime_r(&t, &local);
+   int key = (local.tm_year + 1900) * 10000 + (local.tm_mon + 1) * 100 + local.tm_mday;
+   if(key != g->daykey) {
+      g->ylast = g->yday;
+      g->yday = 0.0;
+      g->daykey = key;
+      g->cloud = 0.2 + 0.8 * (rand_r(&g->seed) % 1000) / 1000.0;
+   }
+
+   double sh = sun_height(t);
+   double iload = (local.tm_hour >= 18 && local.tm_hour < 23) ? 1.5 : 1.0;
+   double vbat = 11.8 + 1.6 * g->soc;
+   double ppv = (sh > 0) ? GEN_PANEL * sh * g->cloud : 0.0;
+   if(g->soc >= 1.0 && ppv > vbat * iload) ppv = vbat * iload;   // float, the controller limits
+   double ibat = ppv / vbat - iload;
+   double vpnl = (sh > 0) ? 17.0 + 3.0 * sh : 0.4;
+   int opcs = (ppv <= 0) ? 0 : (g->soc >= 0.99) ? 5 : (g->soc > 0.9) ? 4 : 3;
+
+   double hrs = dt / 3600.0;
+   g->soc = g->soc + vbat * ibat * hrs / GEN_CAPACITY;
+   if(g->soc > 1.0) g->soc = 1.0;
+   if(g->soc < 0.0) g->soc = 0.0;
+   g->epv = g->epv + ppv * hrs;
+   g->yday = g->yday + ppv * hrs;
+   if(ibat > 0) g->echg = g->echg + vbat * ibat * hrs;
+   else g->edis = g->edis - vbat * ibat * hrs;
+   g->eload = g->eload + vbat * iload * hrs;
+
+   snprintf(buf, len, "%lld:%.3f:%.3f:%.3f:%.2f:%.3f:%d:%d:%.4f:%.4f:%.4f:%.4f:%.0f:%.0f:%.0f",
+            (long long) t, vbat, ibat, vpnl, ppv, iload, opcs, (sh > 0) ? 0 : 1,
+            g->epv, g->echg, g->edis, g->eload, floor(g->epv / 10) * 10,
+            floor(g->yday / 10) * 10, floor(g->ylast / 10) * 10);
+}
+
+/* ------------------------------------------------------------ *
+ * make_rrd() creates the RRD file with nyr years of data up to *
+ * now, unless an up to date one exists. The updates go to      *
+ * librrd in batches of GEN_BATCH.                              *
+ * return code: the first time with data, -1 on errors          *
+ * ------------------------------------------------------------ */
+#define GEN_BATCH 1000
+time_t make_rrd(const char *file, int nyr) {
+   static char buf[GEN_BATCH][160];
+   const char *argv[GEN_BATCH];
+   time_t tend = time(NULL) / 60 * 60;
+   time_t tstart = (tend - (time_t) nyr * 365 * 86400) / 86400 * 86400;
+   time_t tminute = tend - 14 * 86400;
+   struct gen g = { 0.5, 0, 0, 0, 0, 0, 0, 0, 0.5, 1 };
+   struct stat st;
+   time_t t, tprev = tstart;
+   int n = 0;
+
+   if(stat(file, &st) == 0 && rrd_last_r(file) > tend - 86400) {
+      if(verbose == 1) printf("Debug: reusing %s\n", file);
+      return(tstart + 86400);
+   }
+   remove(file);
+   if(verbose == 1) printf("Debug: creating %s with %d years of data\n", file, nyr);
+
+   if(rrd_create_r(file, 60, tstart, sizeof(rrd_schema) / sizeof(rrd_schema[0]), rrd_schema) != 0) {
+      printf("Error: cannot create %s: %s\n", file, rrd_get_error());
+      return(-1);
+   }
+   for(t = tstart + 300; t <= tend; t = t + ((t >= tminute) ? 60 : 300)) {
+      gen_sample(&g, t, (long) (t - tprev), buf[n], sizeof(buf[n]));
+      argv[n] = buf[n];
+      tprev = t;
+      if(++n < GEN_BATCH && t + 60 <= tend) continue;
+      if(rrd_update_r(file, NULL, n, argv) != 0) {
+         printf("Error: cannot update %s: %s\n", file, rrd_get_error());
+         return(-1);
+      }
+      n = 0;
+   }
+   return(tstart + 86400);
+}
+
+/* ------------------------------------------------------------ *
+ * run_pvpower() runs pvpower once with -T, and adds the phase  *
+ * times of its tables into v[B_WALL..B_ROWS]. A "time" line    *
+ * that doesn't parse is an error, so a change of the -T format *
+ * stops the benchmark instead of timing zeros.                 *
+ * return code: 0 = success, -1 on errors                       *
+ * ------------------------------------------------------------ */
+int run_pvpower(const char *cmd, double *v) {
+   char line[256], table[16];
+   double fetch, reduce, render, write, wall;
+   long rows;
+   int i, found = 0, tables = 0, bad = 0;
+
+   for(i = 0; i < B_COUNT; i++) v[i] = 0.0;
+   FILE *fp = popen(cmd, "r");
+   if(fp == NULL) {
+      printf("Error: cannot run [%s].\n", cmd);
+      return(-1);
+   }
+   while(fgets(line, sizeof(line), fp) != NULL) {
+      if(sscanf(line, "time table=%15s fetch=%lf reduce=%lf render=%lf write=%lf rows=%ld",
+                table, &fetch, &reduce, &render, &write, &rows) == 6) {
+         v[B_FETCH] = v[B_FETCH] + fetch;
+         v[B_REDUCE] = v[B_REDUCE] + reduce;
+         v[B_RENDER] = v[B_RENDER] + render;
+         v[B_WRITE] = v[B_WRITE] + write;
+         v[B_ROWS] = v[B_ROWS] + rows;
+         tables++;
+      }
+      else if(sscanf(line, "time table=total wall=%lf", &wall) == 1) {
+         v[B_WALL] = wall;
+         found = 1;
+      }
+      else if(strncmp(line, "time ", 5) == 0) {
+         printf("Error: cannot parse pvpower -T output: %s", line);
+         bad = 1;
+      }
+      else printf("pvpower: %s", line);            // errors, or -v output
+   }
+   if(pclose(fp) != 0 || found == 0 || tables == 0 || bad == 1) {
+      printf("Error: [%s] failed.\n", cmd);
+      return(-1);
+   }
+   return(0);
+}
+
+int cmp_double(const void *a, const void *b) {
+   double x = *(const double *) a, y = *(const double *) b;
+   return((x > y) - (x < y));
+}
+
+/* ------------------------------------------------------------ *
+ * bench_mode() times one mode and report on the RRD file, and  *
+ * prints its CSV line with the median of each value.           *
+ * return code: 0 = success, -1 on errors                       *
+ * ------------------------------------------------------------ */
+int bench_mode(const char *file, int nyr, time_t tfirst, const struct mode *md, const char *rep) {
+   static double v[100][B_COUNT];
+   double col[100];
+   char args[256], cmd[PATH_MAX + 512], from[32];
+   int r, i;
+
+   snprintf(from, sizeof(from), "%lld", (long long) tfirst);
+   snprintf(args, sizeof(args), md->args, from);
+   snprintf(cmd, sizeof(cmd), "%s -s %s -r %s -o %s -T %s", pvpower, file, rep, outfmt, args);
+   if(verbose == 1) printf("Debug: %s\n", cmd);
+
+   if(md->cache == C_WARM) {
+      remove("cache.dat");
+      if(run_pvpower(cmd, v[0]) != 0) return(-1);
+   }
+   for(r = 0; r < runs; r++) {
+      if(md->cache == C_COLD) remove("cache.dat");
+      if(run_pvpower(cmd, v[r]) != 0) return(-1);
+   }
+
+   printf("%d,%s,%s,%d", nyr, rep, md->name, runs);
+   for(i = 0; i < B_COUNT; i++) {
+      for(r = 0; r < runs; r++) col[r] = v[r][i];
+      qsort(col, runs, sizeof(double), cmp_double);
+      double med = (runs % 2 == 1) ? col[runs / 2] : (col[runs / 2 - 1] + col[runs / 2]) / 2;
+      if(i == B_ROWS) printf(",%.0f", med);
+      else printf(",%.6f", med);
+   }
+   printf("\n");
+   fflush(stdout);
+   return(0);
+}
+
+int main(int argc, char *argv[]) {
+   char file[32];
+   unsigned int m;
+   int y;
+
+   parseargs(argc, argv);
+
+   /* ------------------------------------------------------------ *
+    * Work in workdir, so pvpower needs its absolute path.         *
+    * ------------------------------------------------------------ */
+   char *path = realpath(pvpower, NULL);
+   if(path == NULL || access(path, X_OK) != 0) {
+      printf("Error: Cannot find pvpower program [%s].\n", pvpower);
+      exit(-1);
+   }
+   strncpy(pvpower, path, sizeof(pvpower) - 1);
+   free(path);
+   mkdir(workdir, 0755);
+   if(chdir(workdir) != 0) {
+      printf("Error: Cannot use work directory [%s].\n", workdir);
+      exit(-1);
+   }
+
+   printf("years,report,mode,runs,wall,fetch,reduce,render,write,rows\n");
+   for(y = 0; y < nyears; y++) {
+      snprintf(file, sizeof(file), "solar-%dy.rrd", years[y]);
+      time_t tfirst = make_rrd(file, years[y]);
+      if(tfirst < 0) exit(-1);
+
+      for(m = 0; m < sizeof(modes) / sizeof(modes[0]); m++) {
+         if(bench_mode(file, years[y], tfirst, &modes[m], "energy") != 0) exit(-1);
+         if(modes[m].minmax == 1 && bench_mode(file, years[y], tfirst, &modes[m], "minmax") != 0) exit(-1);
+      }
+   }
+   exit(0);
+}
@@ -3,43 +3,148 @@
  * purpose:     Calculate power generation and energy balance   *
  *              from RRD db, write a html-encoded file with a   *
  *              12-day/month/year table, to be included using   *
- *              e.g. <?php include("./daypower.htm"); ?>.       *
+ *              e.g. <?php include("./daypower.htm"); ?>, or    *
+ *              the same table data as CSV or JSON (-o). -q     *
+ *              runs the report over any range instead.         *
  *                                                              *
  * RRD API:     http://oss.oetiker.ch/rrdtool/doc/librrd.en.html*
  *                                                              *
  * author:      04/11/2018 Frank4DD                             *
  *                                                              *
- * compile: gcc -I/srv/app/rrdtool/include pvpower.c -o pvpower *
- *              -L/srv/app/rrdtool/lib -lrrd                    *
+ * compile: gcc -I/srv/app/rrdtool/include pvpower.c reduce.c   *
+ *          outbuf.c -o pvpower -L/srv/app/rrdtool/lib -lrrd    *
+ *          -lm -lpthread                                       *
  *                                                              *
- * This code is adopted from pi-weather momimax.c which shows   *
- * the min max temp value tables. Its stil WIP to determine the *
- * meaningful data. Daily power values seem OK, but monthly and *
- * yearly TBD. The averaging consolidation may not be helpful   *
- * except for graphing trends.                                  *
+ * RRAs: energy cells are the increase of the counters epv,     *
+ * echg and edis (getvictron -e) in the MAX RRA, or the AVERAGE *
+ * sums of ppnl and vbat*ibat without them. -r minmax reads the *
+ * MIN and MAX RRAs. Each table takes the coarsest RRA that     *
+ * reaches back far enough, see plan_rows(), -v shows it. The   *
+ * tables render in threads, librrd must be thread-safe (1.5+). *
  * ------------------------------------------------------------ */
+#define _XOPEN_SOURCE 700   // for strptime()
+#define _DEFAULT_SOURCE 1
 #include <stdlib.h>
 #include <stdio.h>
+#include <string.h>
+#include <unistd.h>
 #include <ctype.h>
 #include <time.h>
 #include <math.h>
+#include <pthread.h>
 #include <rrd.h>
+#include "reduce.h"
+#include "outbuf.h"
 
 /* ------------------------------------------------------------ *
  * Global variables and defaults                                *
  * ------------------------------------------------------------ */
-FILE *html;
+enum { T_DAY, T_MON, T_YEAR, T_RANGE, T_COUNT };
+outbuf out[T_COUNT];               // the output file per table, see run_job()
 int verbose = 0;
-int outtype = 0;
+int outtype = 0;                   // bitmask of tables, 1 << T_DAY etc.
 char rrdfile[256];
-char htmfile[256];
-unsigned long ds_cnt = 0;
-char **ds_namv;
-rrd_value_t *rrddata;
-rrd_value_t *mindata;
-rrd_value_t *maxdata;
+char outfile[T_COUNT][256];        // output file per table
+enum { FMT_HTML, FMT_CSV, FMT_JSON };
+int outfmt = FMT_HTML;             // output format, see -o
+char cachefile[256];               // daily totals cache file, see -c
+enum { REP_ENERGY, REP_MINMAX };
+int report = REP_ENERGY;           // table content, see -r
+enum { G_HOUR, G_DAY, G_WEEK, G_MONTH, G_SEASON, G_YEAR, G_COUNT };
+int group = -1;                    // range report grouping, see -g
+time_t qfrom = 0;                  // range report start, see -f
+time_t qto = 0;                    // range report end, see -t, 0 = now
+int timing = 0;                    // set when arg -T is given
+enum { CF_AVG, CF_MAX, CF_MIN, CF_COUNT }; // RRA of a fetch slot, see load_rows()
+enum { R_DELTA, R_INTEGRAL, R_DAYMAX, R_MIN, R_MAX }; // reducers, see agg_run()
+#define AGG_MAXCOL 366             // max table columns per agg_run()
+#define AGG_MAXSPEC 8              // max specs per agg_run()
+#define MAXSEG 3                   // max fetches per slot, see plan_rows()
+#define MAXARCH 16                 // max RRAs of the RRD, see rrd_archives()
+struct fetch {                     // one rrd_fetch_r() result, see fetch_rows()
+   const char *cf;                 // consolidation function
+   time_t start;                   // start time of the first row
+   time_t end;                     // end time of the last row
+   unsigned long step;             // row step in seconds
+   unsigned long cnt;              // DS count, values per row
+   long rows;                      // number of rows
+   char **namv;                    // DS names
+   rrd_value_t *data;              // the rows, NULL if none loaded
+   time_t lo;                      // part of the slot range it holds,
+   time_t hi;                      // lo..hi, see plan_rows()
+};
+struct slot {                      // loaded rows of one RRA type, see load_rows()
+   const char *cf;                 // consolidation function
+   struct fetch seg[MAXSEG];       // one fetch per archive, oldest first
+   int nseg;                       // number of loaded fetches
+   int failed;                     // set if the RRA has no data for us
+   time_t from;                    // planned fetch range, set in main()
+   time_t till;
+   double tfetch;                  // seconds spent in rrd_fetch_r()
+   long nrows;                     // rows fetched
+};
+static const char *cf_name[CF_COUNT] = { "AVERAGE", "MAX", "MIN" };
+struct archive {                   // one RRA of the RRD, see rrd_archives()
+   int cf;                         // CF_AVG etc.
+   unsigned long step;             // row step in seconds
+   time_t first;                   // first usable column bound, see rrd_archives()
+};
+struct archive arch[MAXARCH];
+int arch_cnt = -1;                 // number of RRAs, -1 = not read yet
+#define MAXDS 32                   // max DS names kept, see rrd_archives()
+char ds_name[MAXDS][20];           // DS names of the RRD
+int ds_cnt = -1;                   // number of DS names, -1 = unknown
+struct aggspec {                   // one value per table column
+   int cf;                         // RRA to read, CF_AVG etc.
+   const char *ds;                 // DS name
+   const char *ds2;                // R_INTEGRAL: integrate ds * ds2, or NULL
+   int reducer;                    // R_DELTA etc.
+};
+struct table {                     // computed table, see write_table()
+   int type;                       // T_DAY etc.
+   int ncol;                       // number of columns, 12 or up to AGG_MAXCOL
+   time_t bound[AGG_MAXCOL + 1];   // column bounds, see table_bounds()
+   time_t tend;                    // end of the last column
+   int nval;                       // values per column
+   const char **name;              // value names for CSV and JSON
+   double v[6 * AGG_MAXCOL];       // value n of column c is v[n * ncol + c]
+};
+struct job {                       // tables that share their rows, see run_job()
+   int tables;                     // bitmask of tables, 1 << T_DAY etc.
+   time_t tsnow;                   // the time the tables end
+   struct slot rra[CF_COUNT];      // the rows of these tables
+   pthread_t thread;
+   int started;                    // set if the thread runs
+   int status;                     // 0, or -1 if a table failed, see run_job()
+};
+struct job jobs[T_COUNT];
+enum { P_FETCH, P_REDUCE, P_RENDER, P_WRITE, P_COUNT }; // phases, see -T
+double ptime[T_COUNT + 1][P_COUNT];  // seconds per table and phase, [T_COUNT] is main()
+long prows[T_COUNT + 1];           // rows fetched per table
+struct mark {                      // a point in time, see phase_mark()
+   double t;
+   double tfetch;
+   long nrows;
+};
+static const char *table_name[T_COUNT + 1] = { "day", "month", "year", "range", "main" };
+struct daytotal {
+   int date;                       // local date as yyyymmdd
+   double ppv;                     // PV energy [Wh], counter delta
+   double bal;                     // battery balance [Wh]
+   double yld;                     // controller day yield [Wh] or NAN
+};
+struct daytotal *dcache = NULL;    // cached days, sorted by date
+int dc_cnt = 0;                    // number of cached days
+int dc_size = 0;                   // allocated cache entries
+int dc_changed = 0;                // set if days were added
+time_t tfin = 0;                   // days before tfin are finished
 extern char *optarg;
 extern int optind, opterr, optopt;
+static const char *report_title[] = { "Power Generation and Energy Balance +/-",
+                                      "Battery and Panel Min/Max" };
+static const char *group_name[] = { "hour", "day", "week", "month", "season", "year" };
+static const char *group_title[] = { "Hourly", "Daily", "Weekly", "Monthly", "Seasonal", "Yearly" };
+static const char *season_name[] = { "winter", "spring", "summer", "autumn" };
 static char mon_name[12][3] = { "Jan", "Feb", "Mar", "Apr",
                                 "May", "Jun", "Jul", "Aug",
                                 "Sep", "Oct", "Nov", "Dec" };
@@ -48,21 +153,62 @@ static char mon_name[12][3] = { "Jan", "Feb", "Mar", "Apr",
  * print_usage() prints the programs commandline instructions.  *
  * ------------------------------------------------------------ */
 void usage() {
-   static char const usage[] = "Usage: pvpower -s [rrd-file] -d|-m [html-output] [-v]\n\
+   static char const usage[] = "Usage: pvpower -s [rrd-file] -d|-m|-y [output-file] [-r report] [-o html|csv|json] [-c cache-file] [-v]\n\
+       pvpower -s [rrd-file] -q [output-file] -f [from] [-t to] -g [group] [-r report] [-o html|csv|json] [-v]\n\
    Command line parameters have the following format:\n\
    -s   RRD file and path, Example: -s /home/pi/pi-ws01/rrd/weather.rrd\n\
    -d   create the 12-day power generation output, and write it into HTML file and path\n\
    -m   create the 12-month power generation output, and write it into HTML file and path\n\
    -y   create the 12-year power generation output, and write it into HTML file and path\n\
+        -d, -m and -y can be combined to create several tables in one run\n\
+   -q   create a report over the range -f..-t, and write it into file and path\n\
+   -f   range start, local date/time or Unix seconds, Example: -f 2026-03-01 or -f \"2026-03-01 06:00\"\n\
+   -t   optional, range end, local date/time or Unix seconds, default: now\n\
+   -g   range grouping: hour, day, week (ISO), month, season (Dec-Feb winter etc.) or year\n\
+   -r   optional, table content: energy (default), or minmax for the vbat, vpnl and ibat extremes\n\
+   -o   optional, output format html (default), csv or json\n\
+   -c   optional, daily totals cache file, finished days are read from there (energy -d|-m|-y only)\n\
+   -T   optional, print the run time per table: fetch, reduce, render and write seconds\n\
    -h   optional, display this message\n\
    -v   optional, enables debug output\n\
    Usage examples:\n\
 ./pvpower -s /home/pi/pi-solar/rrd/solar.rrd -d /home/pi/pi-solar/web/daypower.htm\n\
 ./pvpower -s /home/pi/pi-solar/rrd/solar.rrd -m /home/pi/pi-solar/web/monpower.htm\n\
-./pvpower -s /home/pi/pi-solar/rrd/solar.rrd -y /home/pi/pi-solar/web/yearpower.htm\n";
+./pvpower -s /home/pi/pi-solar/rrd/solar.rrd -y /home/pi/pi-solar/web/yearpower.htm\n\
+./pvpower -s /home/pi/pi-solar/rrd/solar.rrd -d /home/pi/pi-solar/web/daypower.htm \\\n\
+          -m /home/pi/pi-solar/web/monpower.htm -y /home/pi/pi-solar/web/yearpower.htm\n\
+./pvpower -s /home/pi/pi-solar/rrd/solar.rrd -c /home/pi/pi-solar/rrd/daytotals.dat \\\n\
+          -d /home/pi/pi-solar/web/daypower.htm\n\
+./pvpower -s /home/pi/pi-solar/rrd/solar.rrd -r minmax -d /home/pi/pi-solar/web/daymimax.htm\n\
+./pvpower -s /home/pi/pi-solar/rrd/solar.rrd -o json -m /home/pi/pi-solar/web/monpower.json\n\
+./pvpower -s /home/pi/pi-solar/rrd/solar.rrd -o csv -q /tmp/weeks.csv -f 2026-01-01 -t 2026-07-01 -g week\n";
    printf(usage);
 }
 
+/* ------------------------------------------------------------ *
+ * parse_time() accepts a unix timestamp or a local date/time.  *
+ * ------------------------------------------------------------ */
+time_t parse_time(const char *str) {
+   static const char *fmt[] = { "%Y-%m-%d %H:%M:%S", "%Y-%m-%d %H:%M", "%Y-%m-%d" };
+   const char *p = str;
+   unsigned int i;
+
+   while(isdigit((unsigned char) *p)) p++;
+   if(*p == '\0' && p != str) return (time_t) atoll(str);
+
+   for(i = 0; i < sizeof(fmt)/sizeof(fmt[0]); i++) {
+      struct tm tm;
+      memset(&tm, 0, sizeof(tm));
+      char *end = strptime(str, fmt[i], &tm);
+      if(end != NULL && *end == '\0') {
+         tm.tm_isdst = -1;
+         return mktime(&tm);
+      }
+   }
+   printf("Error: Cannot parse time argument [%s].\n", str);
+   exit(-1);
+}
+
 /* ------------------------------------------------------------ *
  * parseargs() checks the commandline arguments with C getopt   *
  * ------------------------------------------------------------ */
@@ -72,7 +218,7 @@ void parseargs(int argc, char* argv[]) {
 
    if(argc == 1) { usage(); exit(-1); }
 
-   while ((arg = (int) getopt (argc, argv, "s:d:m:y:vh")) != -1)
+   while ((arg = (int) getopt (argc, argv, "s:d:m:y:q:f:t:g:r:o:c:Tvh")) != -1)
       switch (arg) {
          // arg -s + source RRD file, type: string
          // mandatory, example: /opt/raspi/data/weather.rrd
@@ -81,30 +227,100 @@ void parseargs(int argc, char* argv[]) {
             strncpy(rrdfile, optarg, sizeof(rrdfile));
             break;
 
-         // arg -d + dst HTML file, type: string
-         // either -d, -m or -y is mandatory, example: /tmp/t1.htm
+         // arg -d + dst output file, type: string
+         // at least one of -d, -m or -y is mandatory, example: /tmp/t1.htm
          case 'd':
-            outtype = 1;
+            outtype |= 1 << T_DAY;
             if(verbose == 1) printf("Debug: arg -d, value %s\n", optarg);
-            strncpy(htmfile, optarg, sizeof(htmfile));
+            strncpy(outfile[T_DAY], optarg, sizeof(outfile[T_DAY]));
             break;
 
-         // arg -m + dst HTML file, type: string
-         // either -d, -m or -y is mandatory, example: /tmp/t1.htm
+         // arg -m + dst output file, type: string
+         // at least one of -d, -m or -y is mandatory, example: /tmp/t1.htm
          case 'm':
-            outtype = 2;
+            outtype |= 1 << T_MON;
             if(verbose == 1) printf("Debug: arg -m, value %s\n", optarg);
-            strncpy(htmfile, optarg, sizeof(htmfile));
+            strncpy(outfile[T_MON], optarg, sizeof(outfile[T_MON]));
             break;
 
-         // arg -y + dst HTML file, type: string
-         // either -d, -m or -y is mandatory, example: /tmp/t1.htm
+         // arg -y + dst output file, type: string
+         // at least one of -d, -m or -y is mandatory, example: /tmp/t1.htm
          case 'y':
-            outtype = 3;
+            outtype |= 1 << T_YEAR;
             if(verbose == 1) printf("Debug: arg -y, value %s\n", optarg);
-            strncpy(htmfile, optarg, sizeof(htmfile));
+            strncpy(outfile[T_YEAR], optarg, sizeof(outfile[T_YEAR]));
+            break;
+
+         // arg -q + dst output file, type: string
+         // optional range report, needs -f and -g, example: /tmp/weeks.csv
+         case 'q':
+            outtype |= 1 << T_RANGE;
+            if(verbose == 1) printf("Debug: arg -q, value %s\n", optarg);
+            strncpy(outfile[T_RANGE], optarg, sizeof(outfile[T_RANGE]));
+            break;
+
+         // arg -f + range start, type: local date/time or Unix seconds
+         // mandatory with -q, example: 2026-03-01
+         case 'f':
+            if(verbose == 1) printf("Debug: arg -f, value %s\n", optarg);
+            qfrom = parse_time(optarg);
+            break;
+
+         // arg -t + range end, type: local date/time or Unix seconds
+         // optional with -q, default: now
+         case 't':
+            if(verbose == 1) printf("Debug: arg -t, value %s\n", optarg);
+            qto = parse_time(optarg);
             break;
 
+         // arg -g + range grouping, type: string
+         // mandatory with -q, hour, day, week, month, season or year
+         case 'g':
+            if(verbose == 1) printf("Debug: arg -g, value %s\n", optarg);
+            for(group = G_COUNT - 1; group >= 0; group--)
+               if(strcmp(optarg, group_name[group]) == 0) break;
+            if(group < 0) {
+               printf("Error: Unknown grouping `%s', use hour, day, week, month, season or year.\n", optarg);
+               exit(-1);
+            }
+            break;
+
+         // arg -r + report name, type: string
+         // optional, energy or minmax, default: energy
+         case 'r':
+            if(verbose == 1) printf("Debug: arg -r, value %s\n", optarg);
+            if(strcmp(optarg, "energy") == 0) report = REP_ENERGY;
+            else if(strcmp(optarg, "minmax") == 0) report = REP_MINMAX;
+            else {
+               printf("Error: Unknown report `%s', use energy or minmax.\n", optarg);
+               exit(-1);
+            }
+            break;
+
+         // arg -o + output format, type: string
+         // optional, html, csv or json, default: html
+         case 'o':
+            if(verbose == 1) printf("Debug: arg -o, value %s\n", optarg);
+            if(strcmp(optarg, "html") == 0) outfmt = FMT_HTML;
+            else if(strcmp(optarg, "csv") == 0) outfmt = FMT_CSV;
+            else if(strcmp(optarg, "json") == 0) outfmt = FMT_JSON;
+            else {
+               printf("Error: Unknown output format `%s', use html, csv or json.\n", optarg);
+               exit(-1);
+            }
+            break;
+
+         // arg -c + daily totals cache file, type: string
+         // optional, example: /home/pi/pi-solar/rrd/daytotals.dat
+         case 'c':
+            if(verbose == 1) printf("Debug: arg -c, value %s\n", optarg);
+            strncpy(cachefile, optarg, sizeof(cachefile));
+            break;
+
+         // arg -T timing, type: flag, optional
+         case 'T':
+            timing = 1; break;
+
          // arg -v verbose, type: flag, optional
          case 'v':
             verbose = 1; break;
@@ -127,140 +343,989 @@ void parseargs(int argc, char* argv[]) {
        exit(-1);
     }
     if(outtype == 0) {
-       printf("Error: Cannot get htm file argument, missing -d|-m?.\n");
+       printf("Error: Cannot get output file argument, missing -d|-m|-y|-q?.\n");
+       exit(-1);
+    }
+    int t;
+    for(t = 0; t < T_COUNT; t++) {
+       if((outtype & (1 << t)) && strlen(outfile[t]) < 3) {
+          printf("Error: Cannot get valid -%c output file argument.\n", "dmyq"[t]);
+          exit(-1);
+       }
+    }
+    if((outtype & (1 << T_RANGE)) && (qfrom == 0 || group < 0)) {
+       printf("Error: Range report -q needs the -f start and -g grouping arguments.\n");
+       exit(-1);
+    }
+    if(! (outtype & (1 << T_RANGE)) && (qfrom != 0 || qto != 0 || group >= 0)) {
+       printf("Error: -f, -t and -g are only used with the -q range report.\n");
        exit(-1);
     }
-    if (strlen(htmfile) < 3) {
-       printf("Error: Cannot get valid -d htm file argument.\n");
+    if(qto != 0 && qto <= qfrom) {
+       printf("Error: Range end -t must be after the start -f.\n");
+       exit(-1);
+    }
+    if(strlen(cachefile) > 0 && strlen(cachefile) < 3) {
+       printf("Error: Cannot get valid -c cache file argument.\n");
        exit(-1);
     }
 }
 
-void year_headhtml(int year){
-   fprintf(html, "<tr><td colspan=12 class=\"monthhead\">Yearly Power Generation and Energy Balance +/-</td></tr>\n");
-   fprintf(html, "<tr>\n");
+/* ------------------------------------------------------------ *
+ * ds_index() returns the column of DS name in the fetch result *
+ * or -1 if the RRD does not have it. The specs name their DS,  *
+ * so the loops over the rows don't depend on the DS order in   *
+ * rrdcreate.sh.                                                *
+ * ------------------------------------------------------------ */
+int ds_index(char **namv, unsigned long cnt, const char *name) {
+   unsigned long i;
+   for(i = 0; i < cnt; i++)
+      if(strcmp(namv[i], name) == 0) return(i);
+   return(-1);
+}
 
-   /* ------------------------------------------------------------- *
-    *  Cycle through the 12 year history columns, oldest first      *
-    * ------------------------------------------------------------- */
+/* ------------------------------------------------------------ *
+ * fetch_free() releases the rows and DS names of a fetch. They *
+ * are allocated by librrd, so they go back with rrd_freemem(). *
+ * slot_free() releases all fetches of a slot.                  *
+ * ------------------------------------------------------------ */
+void fetch_free(struct fetch *f) {
+   unsigned long i;
+   if(f->data == NULL) return;
+   for(i = 0; i < f->cnt; i++) rrd_freemem(f->namv[i]);
+   rrd_freemem(f->namv);
+   rrd_freemem(f->data);
+   f->namv = NULL;
+   f->data = NULL;
+}
+
+void slot_free(struct slot *s) {
    int i;
-   for(i = 11; i >= 0; i--) {
-      /* ------------------------------------------------------------- *
-       * Create the header row for individual months                   *
-       * ------------------------------------------------------------- */
-      int show_year = year - i;
-      if(verbose == 1) printf("Debug: show year=%d\n", show_year);
-      fprintf(html, "   <td class=\"monthcell\">%d</td>\n", show_year);
+   for(i = 0; i < s->nseg; i++) fetch_free(&s->seg[i]);
+   s->nseg = 0;
+}
+
+/* ------------------------------------------------------------ *
+ * clock_sec() returns a monotonic time in seconds for -T.      *
+ * ------------------------------------------------------------ */
+double clock_sec() {
+   struct timespec ts;
+   clock_gettime(CLOCK_MONOTONIC, &ts);
+   return(ts.tv_sec + ts.tv_nsec / 1e9);
+}
+
+/* ------------------------------------------------------------ *
+ * phase_mark() adds the time since the last mark m to phase ph *
+ * of table type, and sets m to now. The part of it the slots   *
+ * of rra spent in rrd_fetch_r() goes to P_FETCH instead. The   *
+ * first mark of a zeroed m only sets it. A table is computed   *
+ * by one thread, so the times need no lock.                    *
+ * ------------------------------------------------------------ */
+void phase_mark(struct mark *m, const struct slot *rra, int type, int ph) {
+   struct mark now = { clock_sec(), 0.0, 0 };
+   int cf;
+
+   for(cf = 0; cf < CF_COUNT; cf++) {
+      now.tfetch = now.tfetch + rra[cf].tfetch;
+      now.nrows = now.nrows + rra[cf].nrows;
    }
-   fprintf(html, "</tr>\n");
+   if(m->t > 0) {
+      ptime[type][P_FETCH] = ptime[type][P_FETCH] + now.tfetch - m->tfetch;
+      ptime[type][ph] = ptime[type][ph] + (now.t - m->t) - (now.tfetch - m->tfetch);
+      prows[type] = prows[type] + now.nrows - m->nrows;
+   }
+   *m = now;
 }
 
-void year_datahtml(int year, time_t ts){
-   int i, j, k = 0;
-   unsigned long step = 86400;
+/* ------------------------------------------------------------ *
+ * fetch_rows() replaces the rows of f with a new fetch of the  *
+ * f->cf RRA for start..end. At most one result per struct      *
+ * fetch is alive, so repeated tables run in constant memory.   *
+ * return code: 0 = success, -1 if librrd has no data for it    *
+ * ------------------------------------------------------------ */
+int fetch_rows(struct fetch *f, time_t start, time_t end, unsigned long step) {
+   fetch_free(f);
+   f->start = start;
+   f->end = end;
+   f->step = step;
+
    /* ------------------------------------------------------------- *
-    *  Create the data row for min max values to display            *
+    * rrd_fetch_r() gets all RRD values for a specific time range.  *
+    * 8x function args: 5x input, 3x output. Returns 0 for success. *
+    * (1) const char *filename,                                     *
+    * (2) const char *consolidation_function,                       *
+    * (3) time_t *start,                                            *
+    * (4) time_t *end,                                              *
+    * (5) unsigned long *step,                                      *
+    * (6) unsigned long *ds_cnt,                                    *
+    * (7) char ***ds_namv,                                          *
+    * (8) rrd_value_t **data);                                      *
     * ------------------------------------------------------------- */
-   fprintf(html, "<tr>\n");
-   for(i = 11; i >= 0; i--) {
-      int show_year = year-i;
-      /* ------------------------------------------------------------- *
-       * Create the start timestamp for rrd fetch, Jan 1st midnight.   *
-       * ------------------------------------------------------------- */
-      struct tm start_tm;
-      start_tm.tm_year = show_year-1900;
-      start_tm.tm_mon  = 0;
-      start_tm.tm_mday = 1;
-      start_tm.tm_hour = 0;
-      start_tm.tm_min  = 0;
-      start_tm.tm_sec  = 0;
-
-      time_t tstart = mktime(&start_tm);
-      if(tstart == -1) printf("Error");
-      if(verbose == 1) printf("Debug: ts=%lld start date=%s", (long long) tstart, ctime(&tstart));
+   int ret = rrd_fetch_r(rrdfile, f->cf, &f->start, &f->end, &f->step, &f->cnt, &f->namv, &f->data);
+   if(ret != 0) {
+      if(verbose == 1) printf("Debug: no %s data: %s\n", f->cf, rrd_get_error());
+      rrd_clear_error();
+      f->data = NULL;
+      return(-1);
+   }
+   f->rows = (f->end - f->start) / f->step;
+   if(verbose == 1) printf("Debug: %s rrd_fetch_r return=%d, ds count=%lu, rows=%ld, step=%lu\n",
+                           f->cf, ret, f->cnt, f->rows, f->step);
+   return(0);
+}
 
-      /* ------------------------------------------------------------- *
-       * Create the end timestamp for rrd fetch, Dec 31st 23:59:59     *
-       * ------------------------------------------------------------- */
-      struct tm end_tm;
-      end_tm.tm_year = show_year-1900;
-      end_tm.tm_mon  = 11;
-      end_tm.tm_mday = 31;
-      end_tm.tm_hour = 23;
-      end_tm.tm_min  = 59;
-      end_tm.tm_sec  = 59;
-
-      time_t tend = mktime(&end_tm);
-      if(tend == -1) printf("Error creating RRD timerange timestamp tend.");
-      if(tend > ts) tend = ts; // if we are at the current date, end at now time
-      if(verbose == 1) printf("Debug: ts=%lld end date=%s", (long long) tend, ctime(&tend));
+/* ------------------------------------------------------------ *
+ * rrd_archives() reads the RRAs of the RRD with rrd_info_r():  *
+ * consolidation function, row step, and the first time it can *
+ * be a column bound: one row after the oldest row, as librrd   *
+ * computes it in rrd_fetch_r(), so a counter has its value     *
+ * there, rounded up to a row bound of the coarsest RRA of the  *
+ * same CF (UTC midnight). A range split there cuts no row. It   *
+ * also keeps the DS names, so RRAs without a DS of the report  *
+ * are not fetched at all. If the info fails, arch_cnt is 0 and *
+ * librrd picks the RRAs, and ds_cnt stays -1.                  *
+ * ------------------------------------------------------------ */
+void rrd_archives() {
+   unsigned long base = 0, last = 0, rows[MAXARCH] = { 0 }, pdp[MAXARCH] = { 0 };
+   int cf[MAXARCH], a, n = 0;
+   char key[32], name[20], date[26];
 
-      /* ------------------------------------------------------------- *
-       * rrd_fetch_r() gets all RRD values for a specific time range.  *
-       * 8x function args: 5x input, 3x output. Returns 0 for success. *
-       * (1) const char *filename,                                     *
-       * (2) const char *consolidation_function,                       *
-       * (3) time_t *start,                                            *
-       * (4) time_t *end,                                              *
-       * (5) unsigned long *step,                                      *
-       * (6) unsigned long *ds_cnt,                                    *
-       * (7) char ***ds_namv,                                          *
-       * (8) rrd_value_t **data);                                      *
-       * ------------------------------------------------------------- */
-      int ret = rrd_fetch_r(rrdfile, "AVERAGE", &tstart, &tend, &step, &ds_cnt, &ds_namv, &rrddata);
-      if (ret != 0) { printf("Error: cannot fetch data from RRD.\n"); exit(-1); }
-      if(verbose == 1) printf("Debug: min rrd_fetch_r return=%d, ds count=%lu\n", ret, ds_cnt);
+   arch_cnt = 0;
+   rrd_info_t *info = rrd_info_r(rrdfile);
+   if(info == NULL) {
+      if(verbose == 1) printf("Debug: no RRA info: %s\n", rrd_get_error());
+      rrd_clear_error();
+      return;
+   }
+   for(a = 0; a < MAXARCH; a++) cf[a] = -1;
+   ds_cnt = 0;
+   for(rrd_info_t *i = info; i != NULL; i = i->next) {
+      if(strcmp(i->key, "step") == 0) base = i->value.u_cnt;
+      else if(strcmp(i->key, "last_update") == 0) last = i->value.u_cnt;
+      else if(sscanf(i->key, "ds[%19[^]]].%31s", name, key) == 2 && strcmp(key, "index") == 0) {
+         if(ds_cnt < MAXDS) strcpy(ds_name[ds_cnt++], name);
+      }
+      else if(sscanf(i->key, "rra[%d].%31s", &a, key) == 2 && a >= 0 && a < MAXARCH) {
+         if(a >= n) n = a + 1;
+         if(strcmp(key, "cf") == 0) {
+            int c;
+            for(c = 0; c < CF_COUNT; c++)
+               if(strcmp(i->value.u_str, cf_name[c]) == 0) cf[a] = c;
+         }
+         if(strcmp(key, "rows") == 0) rows[a] = i->value.u_cnt;
+         if(strcmp(key, "pdp_per_row") == 0) pdp[a] = i->value.u_cnt;
+      }
+   }
+   rrd_info_free(info);
 
-      k=0;
-      int days = ((tend - tstart) / 86400)-1;
-      if(verbose == 1) printf("Debug: result day count=%d\n", days);
+   for(a = 0; a < n; a++) {
+      if(cf[a] < 0 || base * pdp[a] == 0) continue;   // LAST RRAs are not used
+      struct archive *r = &arch[arch_cnt++];
+      r->cf = cf[a];
+      r->step = base * pdp[a];
+      r->first = (time_t) (last - last % r->step) - (time_t) (r->step * rows[a]) + (time_t) r->step;
+   }
+   for(a = 0; a < arch_cnt; a++) {
+      unsigned long maxstep = 0;
+      for(n = 0; n < arch_cnt; n++)
+         if(arch[n].cf == arch[a].cf && arch[n].step > maxstep) maxstep = arch[n].step;
+      arch[a].first = (arch[a].first + (time_t) maxstep - 1) / (time_t) maxstep * (time_t) maxstep;
+      if(verbose == 1) printf("Debug: RRA %s step %lu from %s", cf_name[arch[a].cf], arch[a].step,
+                              ctime_r(&arch[a].first, date));
+   }
+}
 
-      /* ------------------------------------------------------------- *
-       * Go through the returned dataset. For PPV, create sum of daily *
-       * power intake, divide by 24 to get the (Kilo) Watt hour value. *
-       * For balance, the battery current is pos/neg per power surplus *
-       * creating the pos/neg power value when multiplied with voltage *
-       * The set size is 12 days * 24 hrs (60 mins) * 6 data sources:  *
-       * pv watt=ds_namv[3], bat volts=ds_namv[0], bat cur=ds_namv[1]  *
-       * ------------------------------------------------------------- */
-      double ppvday = 0.0;
-      double balday = 0.0;
-
-      for(j=0; j<(days*ds_cnt); j=j+ds_cnt) {
-         k++;
-         if(verbose == 1) printf("Debug: day [%d] value [%d] rrd_fetch_r [%s:%.2f] [%s:%.2f] [%s:%.2f]\n",
-                                  k, j, ds_namv[3], rrddata[j+3], ds_namv[0], rrddata[j], ds_namv[1], rrddata[j+1]);
-         /* since the data is a 24hr avg, we multiply by 24 to get the approx. Watt number */
-         if(! isnan(rrddata[j+3])) ppvday = ppvday + (rrddata[j+3] * 24);
-         if(! isnan(rrddata[j]) && ! isnan(rrddata[j+1])) balday = balday + ((rrddata[j] * rrddata[j+1]) * 24);
+/* ------------------------------------------------------------ *
+ * plan_rows() picks the archives for the cf rows of lo..hi, in *
+ * plan[], oldest first, and returns their number. The report   *
+ * needs rows of step need or finer, e.g. hourly rows to find   *
+ * local midnight, and gets the coarsest archive that reaches   *
+ * back to lo, so it reads the fewest rows. If no such archive  *
+ * reaches back far enough, the range is split: the newer part  *
+ * comes from the archive that reaches back furthest, the older *
+ * part from the next coarser one. The split point only depends *
+ * on the archive, so any part of lo..hi gets the same rows.    *
+ * ------------------------------------------------------------ */
+int plan_rows(int cf, time_t lo, time_t hi, unsigned long need, struct fetch *plan) {
+   time_t t = hi;
+   int a, n = 0;
+
+   if(arch_cnt < 0) rrd_archives();
+   while(t > lo && n < MAXSEG) {
+      int pick = -1;
+      for(a = 0; a < arch_cnt; a++)
+         if(arch[a].cf == cf && arch[a].step <= need && arch[a].first <= lo
+            && (pick < 0 || arch[a].step > arch[pick].step)) pick = a;
+      if(pick >= 0) {
+         plan[n].lo = lo;
+         plan[n].hi = t;
+         plan[n++].step = arch[pick].step;
+         t = lo;
+         break;
+      }
+      for(a = 0; a < arch_cnt; a++)
+         if(arch[a].cf == cf && arch[a].step <= need && arch[a].first < t
+            && (pick < 0 || arch[a].first < arch[pick].first)) pick = a;
+      if(pick >= 0) {
+         plan[n].lo = arch[pick].first;
+         plan[n].hi = t;
+         plan[n++].step = arch[pick].step;
+         t = arch[pick].first;
+      }
+      unsigned long next = 0;                   // the older rows are coarser
+      for(a = 0; a < arch_cnt; a++)
+         if(arch[a].cf == cf && arch[a].step > need && (next == 0 || arch[a].step < next))
+            next = arch[a].step;
+      if(next == 0) break;
+      need = next;
+   }
+
+   if(n == 0) {                                 // no RRA info, librrd decides
+      plan[0].lo = lo;
+      plan[0].hi = hi;
+      plan[0].step = need;
+      return(1);
+   }
+   for(a = 0; a < n / 2; a++) {                 // oldest first
+      struct fetch p = plan[a];
+      plan[a] = plan[n - 1 - a];
+      plan[n - 1 - a] = p;
+   }
+   return(n);
+}
+
+/* ------------------------------------------------------------ *
+ * load_rows() makes sure the RRA slot cf holds the rows for    *
+ * tfirst..tend, with the given step or a finer one, see        *
+ * plan_rows(). Rows that are already loaded and cover the plan *
+ * are kept. The oldest fetch starts one row early, so a        *
+ * counter has its value at tfirst. The range is widened to the *
+ * from..till range main() planned for the other tables.        *
+ * AVERAGE is the base RRA of all tables, if it can't be read   *
+ * the error is printed, see agg_run().                         *
+ * return code: 0 = success, -1 if the RRA has no data for us   *
+ * ------------------------------------------------------------ */
+int load_rows(struct slot *rra, int cf, time_t tfirst, time_t tend, unsigned long step) {
+   struct slot *s = &rra[cf];
+   struct fetch plan[MAXSEG];
+   int i, j, n, have = 0;
+
+   if(s->failed == 1) return(-1);
+   n = plan_rows(cf, tfirst, tend, step, plan);
+   for(i = 0; i < n; i++)
+      for(j = 0; j < s->nseg; j++)
+         if(s->seg[j].lo <= plan[i].lo && s->seg[j].hi >= plan[i].hi
+            && s->seg[j].step <= plan[i].step) { have++; break; }
+   if(n > 0 && have == n) {
+      if(verbose == 1) printf("Debug: %s rows already loaded\n", s->cf);
+      return(0);
+   }
+
+   if(s->from > 0 && s->from < tfirst) tfirst = s->from;
+   if(s->till > tend) tend = s->till;
+   n = plan_rows(cf, tfirst, tend, step, plan);
+
+   slot_free(s);
+   for(i = 0; i < n; i++) {
+      struct fetch *f = &s->seg[i];
+      f->cf = s->cf;
+      f->lo = plan[i].lo;
+      f->hi = plan[i].hi;
+      double t0 = clock_sec();
+      int ret = fetch_rows(f, (i == 0) ? f->lo - plan[i].step : f->lo, f->hi, plan[i].step);
+      s->tfetch = s->tfetch + clock_sec() - t0;
+      if(ret != 0) {
+         slot_free(s);
+         if(cf == CF_AVG) printf("Error: cannot fetch data from RRD.\n");
+         s->failed = 1;
+         return(-1);
+      }
+      s->nseg++;
+      s->nrows = s->nrows + f->rows;
+      if(verbose == 1) printf("Debug: %s rows %lld..%lld have step %lu\n", s->cf,
+                              (long long) f->lo, (long long) f->hi, f->step);
+   }
+   return(0);
+}
+
+/* ------------------------------------------------------------ *
+ * seg_of() returns the fetch of slot s that holds time t, i.e. *
+ * the row ending at t, or NULL if no fetch has it.             *
+ * ------------------------------------------------------------ */
+const struct fetch *seg_of(const struct slot *s, time_t t) {
+   int i;
+   for(i = 0; i < s->nseg; i++)
+      if((t > s->seg[i].lo || (i == 0 && t == s->seg[i].lo)) && t <= s->seg[i].hi)
+         return(&s->seg[i]);
+   return(NULL);
+}
+
+/* ------------------------------------------------------------ *
+ * counter_row() returns the row of f whose time span ends at   *
+ * t, or the one that contains t if t is not step-aligned.      *
+ * ------------------------------------------------------------ */
+long counter_row(const struct fetch *f, time_t t) {
+   return((t - f->start + (time_t) f->step - 1) / (time_t) f->step - 1);
+}
+
+/* ------------------------------------------------------------ *
+ * counter_delta() gets the increase of counter column col for  *
+ * t1..t2. If the end row has no data yet (current hour), it    *
+ * uses the latest row before.                                  *
+ * return code: 0 = success, -1 if the counter can't tell, e.g. *
+ * no data, or a counter reset (lost state file, new firmware)  *
+ * ------------------------------------------------------------ */
+int counter_delta(const struct slot *s, int col, time_t t1, time_t t2, double *delta) {
+   const struct fetch *f1 = seg_of(s, t1), *f2 = seg_of(s, t2);
+   if(f1 == NULL || f2 == NULL) return(-1);
+
+   long k1 = counter_row(f1, t1);
+   long k2 = counter_row(f2, t2);
+   if(k1 < 0 || k1 >= f1->rows || k2 < 0 || k2 >= f2->rows) return(-1);
+
+   rrd_value_t v1 = f1->data[k1 * f1->cnt + col];
+   long kmin = (f1 == f2) ? k1 + 1 : 0;
+   while(k2 > kmin && isnan(f2->data[k2 * f2->cnt + col])) k2--;
+   if(k2 < kmin || isnan(v1) || isnan(f2->data[k2 * f2->cnt + col])) return(-1);
+
+   double d = f2->data[k2 * f2->cnt + col] - v1;
+   if(d < 0.0) return(-1);
+   *delta = d;
+   return(0);
+}
+
+/* ------------------------------------------------------------ *
+ * day_max() gets the highest value of column col between noon  *
+ * and the end of the local day tday..tnext. The controllers    *
+ * daily yield H20 counts up during the day and resets when the *
+ * controller starts a new day, which happens at night, not at  *
+ * midnight. Its highest value after noon is the days yield.    *
+ * It needs hourly rows to find noon.                           *
+ * return code: 0 = success, -1 if there is no data             *
+ * ------------------------------------------------------------ */
+int day_max(const struct slot *s, int col, time_t tday, time_t tnext, double *max) {
+   const struct fetch *f = seg_of(s, tnext);
+   if(f == NULL || f->step != 3600) return(-1);
+
+   long k  = counter_row(f, tday + 43200) + 1;   // first row after noon
+   long k2 = counter_row(f, tnext);
+   if(k < 0 || k2 >= f->rows) return(-1);
+
+   double m = NAN;
+   for(; k <= k2; k++) {
+      rrd_value_t v = f->data[k * f->cnt + col];
+      if(! isnan(v) && (isnan(m) || v > m)) m = v;
+   }
+   if(isnan(m)) return(-1);
+   *max = m;
+   return(0);
+}
+
+/* ------------------------------------------------------------ *
+ * integral() sums the AVERAGE rows whose middle is in t1..t2   *
+ * (t2 excluded), each fetch of the slot for its part of the    *
+ * range. Daily rows are UTC. The average is multiplied by the  *
+ * row hours to get the approx. Watt hour number. With a second *
+ * column, the rows are the product, e.g. vbat * ibat: the      *
+ * battery current is pos/neg per power surplus, creating the   *
+ * pos/neg balance. The rows are summed up with the reduce.c    *
+ * kernels. Rows longer than t1..t2 are left out, so hours of  *
+ * a range report that only has daily rows are NAN, like a      *
+ * column without any row or without any known row. A local day *
+ * is 23 hours on the DST change, it still takes a daily row,   *
+ * see row_span().                                              *
+ * ------------------------------------------------------------ */
+time_t row_span(const struct fetch *f) {
+   return((f->step >= 86400) ? (time_t) f->step - 3600 : (time_t) f->step);
+}
+
+long avg_row(const struct fetch *f, time_t t) {
+   time_t d = t - f->start - (time_t) (f->step / 2);
+   if(d <= 0) return(0);
+   long k = (d + f->step - 1) / f->step;   // first row with middle >= t
+   return((k > f->rows) ? f->rows : k);
+}
+
+double integral(const struct slot *s, int col, int col2, time_t t1, time_t t2) {
+   double sum = 0.0;
+   int i, used = 0;
+
+   for(i = 0; i < s->nseg; i++) {
+      const struct fetch *f = &s->seg[i];
+      long k, k1 = avg_row(f, (t1 > f->lo) ? t1 : f->lo);
+      long k2 = avg_row(f, (t2 < f->hi) ? t2 : f->hi);
+      if(k2 <= k1 || t2 - t1 < row_span(f)) continue;
+      rrd_value_t *rows = f->data + k1 * f->cnt;
+      double hrs = f->step / 3600.0;
+
+      if(verbose == 1) {
+         for(k = k1; k < k2; k++)
+            printf("Debug: row [%ld] [%s:%.2f] [%.2f]\n", k, f->namv[col],
+                   f->data[k * f->cnt + col], (col2 < 0) ? NAN : f->data[k * f->cnt + col2]);
+      }
+      double v = (col2 < 0) ? rr_sum(rows + col, k2 - k1, f->cnt)
+                            : rr_dot(rows + col, rows + col2, k2 - k1, f->cnt);
+      if(isnan(v)) continue;
+      sum = sum + v * hrs;
+      used = 1;
+   }
+   return((used == 1) ? sum : NAN);
+}
+
+/* ------------------------------------------------------------ *
+ * extreme() returns the lowest (R_MIN) or highest (R_MAX) row  *
+ * value of column col, for the rows whose middle is in t1..t2, *
+ * like integral(). NAN if none of the rows is known.           *
+ * ------------------------------------------------------------ */
+double extreme(const struct slot *s, int col, int reducer, time_t t1, time_t t2) {
+   double m = NAN, v;
+   int i;
+
+   for(i = 0; i < s->nseg; i++) {
+      const struct fetch *f = &s->seg[i];
+      long k1 = avg_row(f, (t1 > f->lo) ? t1 : f->lo);
+      long k2 = avg_row(f, (t2 < f->hi) ? t2 : f->hi);
+      if(k2 <= k1 || t2 - t1 < row_span(f)) continue;
+      if(reducer == R_MIN) v = rr_min(f->data + k1 * f->cnt + col, k2 - k1, f->cnt);
+      else v = rr_max(f->data + k1 * f->cnt + col, k2 - k1, f->cnt);
+      if(isnan(m) || (reducer == R_MIN && v < m) || (reducer == R_MAX && v > m)) m = v;
+   }
+   return(m);
+}
+
+/* ------------------------------------------------------------ *
+ * spec_known() returns 1 if the RRD has the DS of at least one *
+ * spec for slot s, from its loaded rows or the DS names of     *
+ * rrd_archives(). The DS are the same in every RRA, so this    *
+ * saves fetching an RRA for DS it doesn't have. If the DS are  *
+ * unknown, it returns 1 so the RRA is fetched and tells.       *
+ * ------------------------------------------------------------ */
+int spec_known(const struct slot *s, int cf, const struct aggspec *spec, int nspec) {
+   int i, d;
+   for(i = 0; i < nspec; i++) {
+      if(spec[i].cf != cf) continue;
+      if(s->nseg > 0) {
+         if(ds_index(s->seg[0].namv, s->seg[0].cnt, spec[i].ds) >= 0) return(1);
+         continue;
+      }
+      if(ds_cnt < 0) return(1);
+      for(d = 0; d < ds_cnt; d++)
+         if(strcmp(ds_name[d], spec[i].ds) == 0) return(1);
+   }
+   return(0);
+}
+
+/* ------------------------------------------------------------ *
+ * agg_run() computes the specs for the ncol table columns with *
+ * the bounds bound[0]..bound[ncol], out[s * ncol + c] gets the *
+ * value of spec s for column c. Columns end at tend at latest, *
+ * and the rows are loaded up to tend. Each RRA is loaded once  *
+ * for all specs, with the row step step[cf] or finer, see      *
+ * plan_rows(). The reducers are:                               *
+ * R_DELTA    counter increase over the column, MAX rows. The   *
+ *            counters only increase, so the MAX of a row is    *
+ *            the counter value at the end of the row.          *
+ * R_INTEGRAL energy sum [Wh] of the AVERAGE rows, integral()   *
+ * R_DAYMAX   highest value after noon, day_max()               *
+ * R_MIN      lowest value of the MIN rows in the column        *
+ * R_MAX      highest value of the MAX rows in the column       *
+ * A value is NAN if the RRD has no data for it. It runs in the *
+ * job threads, so errors go back to run_job().                 *
+ * return code: 0 = success, -1 if the AVERAGE rows can't be    *
+ * fetched, or on too many columns or specs                     *
+ * ------------------------------------------------------------ */
+int agg_run(struct slot *rra, const struct aggspec *spec, int nspec, const time_t *bound,
+            int ncol, time_t tend, const unsigned long *step, double *out) {
+   int s, c, cf;
+
+   if(ncol > AGG_MAXCOL || nspec > AGG_MAXSPEC) {
+      printf("Error: agg_run() got %d columns and %d specs.\n", ncol, nspec);
+      return(-1);
+   }
+   for(s = 0; s < nspec * ncol; s++) out[s] = NAN;
+
+   for(cf = 0; cf < CF_COUNT; cf++) {
+      struct slot *f = &rra[cf];
+      for(s = 0; s < nspec; s++) if(spec[s].cf == cf) break;
+      if(s == nspec) continue;                  // no spec reads this RRA
+
+      if(spec_known(f, cf, spec, nspec) == 0) {
+         if(verbose == 1) printf("Debug: RRD has no %s DS for this report\n", f->cf);
+         continue;
+      }
+      if(load_rows(rra, cf, bound[0], tend, step[cf]) != 0) {
+         if(cf == CF_AVG) return(-1);
+         continue;
+      }
+
+      for(s = 0; s < nspec; s++) {
+         if(spec[s].cf != cf) continue;
+         char **namv = f->seg[0].namv;
+         int col = ds_index(namv, f->seg[0].cnt, spec[s].ds);
+         int col2 = (spec[s].ds2 == NULL) ? -1 : ds_index(namv, f->seg[0].cnt, spec[s].ds2);
+         if(col < 0 || (spec[s].ds2 != NULL && col2 < 0)) continue;
+
+         for(c = 0; c < ncol; c++) {
+            time_t t1 = bound[c];
+            time_t t2 = (bound[c+1] < tend) ? bound[c+1] : tend;
+            double v;
+            if(t2 <= t1) continue;
+            if(spec[s].reducer == R_DELTA && counter_delta(f, col, t1, t2, &v) == 0)
+               out[s * ncol + c] = v;
+            if(spec[s].reducer == R_DAYMAX && day_max(f, col, t1, t2, &v) == 0)
+               out[s * ncol + c] = v;
+            if(spec[s].reducer == R_INTEGRAL)
+               out[s * ncol + c] = integral(f, col, col2, t1, t2);
+            if(spec[s].reducer == R_MIN || spec[s].reducer == R_MAX)
+               out[s * ncol + c] = extreme(f, col, spec[s].reducer, t1, t2);
+         }
+      }
+   }
+   return(0);
+}
+
+/* ------------------------------------------------------------ *
+ * The energy report: PV energy and battery balance. If the RRD *
+ * has the energy counters (getvictron -e), they give the exact *
+ * values. PV energy is the integrated counter epv, the balance *
+ * is charge minus discharge. Columns the counters can't tell   *
+ * fall back to the AVERAGE sums of panel power and battery     *
+ * power. The controller yields H19 and H20 count in 10 Wh      *
+ * steps, see pick_yield().                                     *
+ * ------------------------------------------------------------ */
+static const struct aggspec energy_ctr[] = {
+   { CF_MAX, "yldt", NULL, R_DELTA },
+   { CF_MAX, "epv",  NULL, R_DELTA },
+   { CF_MAX, "echg", NULL, R_DELTA },
+   { CF_MAX, "edis", NULL, R_DELTA },
+   { CF_MAX, "yldd", NULL, R_DAYMAX },
+};
+static const struct aggspec energy_avg[] = {
+   { CF_AVG, "ppnl", NULL,   R_INTEGRAL },
+   { CF_AVG, "vbat", "ibat", R_INTEGRAL },
+};
+
+/* ------------------------------------------------------------ *
+ * pick_yield() returns the controller yield yld if it is well  *
+ * above its 10 Wh resolution, else the integrated value integ. *
+ * A small panel makes 30..50 Wh on a winter day, the 10 Wh     *
+ * steps would be a 20..30% error there. From YLD_MIN on, the   *
+ * error is 2% or less, and the controller counts the energy    *
+ * between our readings too. If integ is NAN, yld is all we     *
+ * have.                                                        *
+ * ------------------------------------------------------------ */
+#define YLD_MIN 500.0   // Wh, 50 yield steps
+
+double pick_yield(double yld, double integ) {
+   if(! isnan(yld) && (yld >= YLD_MIN || isnan(integ))) return(yld);
+   return(integ);
+}
+
+/* ------------------------------------------------------------ *
+ * energy_cols() gets ppv and bal [Wh] for the columns as for   *
+ * agg_run(). yld gets the controllers day yield H20 for local  *
+ * days with hourly rows, else NAN. If useyld is set, the PV    *
+ * energy of a column is the day yield, see pick_yield(). The   *
+ * AVERAGE rows are only fetched if a column needs them.        *
+ * return code: 0 = success, -1 on error, see agg_run()         *
+ * ------------------------------------------------------------ */
+int energy_cols(struct slot *rra, const time_t *bound, int ncol, time_t tend,
+                const unsigned long *step, int useyld, double *ppv, double *bal, double *yld) {
+   double ctr[5 * AGG_MAXCOL], avg[2 * AGG_MAXCOL];
+   int c, need = 0;
+
+   if(agg_run(rra, energy_ctr, 5, bound, ncol, tend, step, ctr) != 0) return(-1);
+   for(c = 0; c < ncol; c++) {
+      double yldt = ctr[c], epv = ctr[ncol + c];
+      double echg = ctr[2 * ncol + c], edis = ctr[3 * ncol + c];
+      yld[c] = ctr[4 * ncol + c];
+      ppv[c] = pick_yield(yldt, epv);
+      if(useyld == 1) ppv[c] = pick_yield(yld[c], ppv[c]);
+      bal[c] = echg - edis;                     // NAN if one is missing
+      if(isnan(ppv[c]) || isnan(bal[c])) need = 1;
+   }
+
+   if(need == 1 && agg_run(rra, energy_avg, 2, bound, ncol, tend, step, avg) != 0) return(-1);
+   for(c = 0; c < ncol; c++) {
+      if(need == 1 && isnan(ppv[c])) ppv[c] = avg[c];
+      if(need == 1 && isnan(bal[c])) bal[c] = avg[ncol + c];
+      if(verbose == 1) printf("Debug: column %lld..%lld ppv [%.2f] balance [%.2f] yield [%.2f]\n",
+                              (long long) bound[c], (long long) bound[c+1], ppv[c], bal[c], yld[c]);
+   }
+   return(0);
+}
+
+/* ------------------------------------------------------------ *
+ * print_energy() writes one table cell with the PV energy and  *
+ * the battery balance, negative balance cells are highlighted. *
+ * ------------------------------------------------------------ */
+void print_energy(outbuf *ob, double ppvday, double balday) {
+   if(ppvday >= 0.0) {
+      /* Highlight days with a negative balance */
+      if(balday > 0.0) ob_printf(ob, "   <td class=\"datacell\">");
+      else ob_printf(ob, "   <td class=\"minuscell\">");
+
+      /* Print the power generation */
+      if(ppvday >= 1000.0)
+         ob_printf(ob, "%.1f&thinsp;KW", ppvday/1000.0);
+      else
+         ob_printf(ob, "%.1f&thinsp;W", ppvday);
+
+      ob_printf(ob, " <br> ");
+      /* Print the power balance */
+      if((balday >= 1000.0) || (balday <= -1000.0))
+         ob_printf(ob, "%+.1f&thinsp;KW</td>\n", balday/1000.0);
+      else
+         ob_printf(ob, "%+.1f&thinsp;W</td>\n", balday);
+   }
+   else  ob_printf(ob, "   <td class=\"emptycell\">N/A</td>\n");
+}
+
+/* ------------------------------------------------------------ *
+ * day_start(), month_start() and year_start() return the local *
+ * midnight that starts table column i, 0 is the oldest column. *
+ * mktime() normalizes negative days and months.                *
+ * ------------------------------------------------------------ */
+time_t day_start(time_t tsnow, int i) {
+   struct tm start_tm;
+   localtime_r(&tsnow, &start_tm);
+   start_tm.tm_mday = start_tm.tm_mday - 12 + i;
+   start_tm.tm_hour = 0;
+   start_tm.tm_min  = 0;
+   start_tm.tm_sec  = 0;
+   start_tm.tm_isdst = -1;
+   time_t t = mktime(&start_tm);
+   if(t == -1) printf("Error creating RRD timerange timestamp for day %d.", i);
+   return(t);
+}
+
+time_t month_start(int mon, int year, int i) {
+   struct tm start_tm = { 0 };
+   start_tm.tm_year = year-1900;
+   start_tm.tm_mon  = mon-12+i;
+   start_tm.tm_mday = 1;
+   start_tm.tm_isdst = -1;
+   time_t t = mktime(&start_tm);
+   if(t == -1) printf("Error creating RRD timerange timestamp for month %d.", i);
+   return(t);
+}
+
+/* ------------------------------------------------------------ *
+ * next_day() returns the local midnight after day start t.     *
+ * ------------------------------------------------------------ */
+time_t next_day(time_t t) {
+   struct tm next_tm;
+   localtime_r(&t, &next_tm);
+   next_tm.tm_mday = next_tm.tm_mday + 1;
+   next_tm.tm_hour = 0;
+   next_tm.tm_min  = 0;
+   next_tm.tm_sec  = 0;
+   next_tm.tm_isdst = -1;
+   return(mktime(&next_tm));
+}
+
+time_t year_start(int year, int i) {
+   struct tm start_tm = { 0 };
+   start_tm.tm_year = year-11-1900+i;
+   start_tm.tm_mday = 1;
+   start_tm.tm_isdst = -1;
+   time_t t = mktime(&start_tm);
+   if(t == -1) printf("Error creating RRD timerange timestamp for year %d.", year-11+i);
+   return(t);
+}
+
+/* ------------------------------------------------------------ *
+ * group_end() returns the end of the range report group that   *
+ * holds t: the next local full hour, midnight, Monday, first   *
+ * of a month, season or year. Seasons are meteorological, the  *
+ * winter is December to February.                              *
+ * ------------------------------------------------------------ */
+time_t group_end(time_t t, int g) {
+   struct tm end_tm;
+   localtime_r(&t, &end_tm);
+   end_tm.tm_min = 0;
+   end_tm.tm_sec = 0;
+   if(g == G_HOUR) return(mktime(&end_tm) + 3600);
+
+   end_tm.tm_hour = 0;
+   end_tm.tm_isdst = -1;
+   if(g == G_DAY)  end_tm.tm_mday = end_tm.tm_mday + 1;
+   if(g == G_WEEK) end_tm.tm_mday = end_tm.tm_mday - (end_tm.tm_wday + 6) % 7 + 7;
+   if(g >= G_MONTH) end_tm.tm_mday = 1;
+   if(g == G_MONTH) end_tm.tm_mon = end_tm.tm_mon + 1;
+   if(g == G_SEASON) end_tm.tm_mon = (end_tm.tm_mon + 1) / 3 * 3 + 2;
+   if(g == G_YEAR) {
+      end_tm.tm_mon = 0;
+      end_tm.tm_year = end_tm.tm_year + 1;
+   }
+   return(mktime(&end_tm));
+}
+
+/* ------------------------------------------------------------ *
+ * group_label() writes the name of the group that holds t,     *
+ * e.g. 2026-10-13 11:00, 2026-W42, or 2025-winter for the      *
+ * winter from December 2025.                                   *
+ * ------------------------------------------------------------ */
+void group_label(time_t t, int g, char *label, size_t len) {
+   static const char *fmt[G_COUNT] = { "%Y-%m-%d %H:00", "%Y-%m-%d", "%G-W%V", "%Y-%m", "", "%Y" };
+   struct tm tm;
+
+   localtime_r(&t, &tm);
+   if(g == G_SEASON)
+      snprintf(label, len, "%d-%s", tm.tm_year + 1900 - (tm.tm_mon < 2),
+               season_name[(tm.tm_mon + 1) / 3 % 4]);
+   else
+      strftime(label, len, fmt[g], &tm);
+}
+
+/* ------------------------------------------------------------ *
+ * date_key() returns the local date of t as number yyyymmdd,   *
+ * the key of the daily totals cache.                           *
+ * ------------------------------------------------------------ */
+int date_key(time_t t) {
+   struct tm key_tm;
+   localtime_r(&t, &key_tm);
+   return((key_tm.tm_year + 1900) * 10000 + (key_tm.tm_mon + 1) * 100 + key_tm.tm_mday);
+}
+
+/* ------------------------------------------------------------ *
+ * cache_find() returns the index of the first cached day with  *
+ * a date >= key, or dc_cnt if there is none (binary search).   *
+ * ------------------------------------------------------------ */
+int cache_find(int key) {
+   int lo = 0, hi = dc_cnt;
+   while(lo < hi) {
+      int mid = (lo + hi) / 2;
+      if(dcache[mid].date < key) lo = mid + 1;
+      else hi = mid;
+   }
+   return(lo);
+}
+
+/* ------------------------------------------------------------ *
+ * cache_has() returns 1 if the day key is in the cache.        *
+ * ------------------------------------------------------------ */
+int cache_has(int key) {
+   int i = cache_find(key);
+   return(i < dc_cnt && dcache[i].date == key);
+}
+
+/* ------------------------------------------------------------ *
+ * cache_add() inserts a day into the sorted cache. Days are    *
+ * mostly added in date order, so this is normally an append.   *
+ * ------------------------------------------------------------ */
+void cache_add(int key, double ppv, double bal, double yld) {
+   int i = cache_find(key);
+   if(i < dc_cnt && dcache[i].date == key) return;
+   if(dc_cnt == dc_size) {
+      dc_size = (dc_size == 0) ? 512 : dc_size * 2;
+      dcache = realloc(dcache, dc_size * sizeof(struct daytotal));
+      if(dcache == NULL) { printf("Error: cannot allocate daily totals cache.\n"); exit(-1); }
+   }
+   memmove(&dcache[i+1], &dcache[i], (dc_cnt - i) * sizeof(struct daytotal));
+   dcache[i].date = key;
+   dcache[i].ppv = ppv;
+   dcache[i].bal = bal;
+   dcache[i].yld = yld;
+   dc_cnt++;
+   dc_changed = 1;
+}
+
+/* ------------------------------------------------------------ *
+ * cache_load() reads the daily totals cache file, one line per *
+ * day: yyyy-mm-dd ppv bal yld, yld is "nan" if the controller  *
+ * had no daily yield. A missing file is an empty cache.        *
+ * ------------------------------------------------------------ */
+void cache_load() {
+   char line[128];
+   int y, m, d;
+   double ppv, bal, yld;
+
+   FILE *fp = fopen(cachefile, "r");
+   if(! fp) {
+      if(verbose == 1) printf("Debug: no daily totals cache %s, creating it\n", cachefile);
+      return;
+   }
+   while(fgets(line, sizeof(line), fp) != NULL) {
+      if(sscanf(line, "%d-%d-%d %lf %lf %lf", &y, &m, &d, &ppv, &bal, &yld) != 6) continue;
+      cache_add(y * 10000 + m * 100 + d, ppv, bal, yld);
+   }
+   fclose(fp);
+   dc_changed = 0;
+   if(verbose == 1) printf("Debug: daily totals cache %s has %d days\n", cachefile, dc_cnt);
+}
+
+/* ------------------------------------------------------------ *
+ * cache_save() writes the cache back if days were added. Like  *
+ * the getvictron state file, it goes to a temp file first.     *
+ * ------------------------------------------------------------ */
+void cache_save() {
+   char tmpfile[265];
+   int i;
+
+   if(dc_changed == 0) return;
+   snprintf(tmpfile, sizeof(tmpfile), "%s.tmp", cachefile);
+   FILE *fp = fopen(tmpfile, "w");
+   if(! fp) {
+      printf("Error open %s for writing.\n", tmpfile);
+      return;
+   }
+   for(i = 0; i < dc_cnt; i++)
+      fprintf(fp, "%04d-%02d-%02d %.4f %.4f %.1f\n", dcache[i].date / 10000,
+              dcache[i].date / 100 % 100, dcache[i].date % 100,
+              dcache[i].ppv, dcache[i].bal, dcache[i].yld);
+   fclose(fp);
+   if(rename(tmpfile, cachefile) != 0)
+      printf("Error: cannot rename %s to %s.\n", tmpfile, cachefile);
+   else if(verbose == 1) printf("Debug: daily totals cache saved, %d days\n", dc_cnt);
+}
+
+/* ------------------------------------------------------------ *
+ * report_free() releases the fetched rows and the daily totals *
+ * cache, and forgets what we learned about the RRD. After it,  *
+ * the tables can be created again from scratch.                *
+ * ------------------------------------------------------------ */
+void report_free() {
+   int j, cf;
+   for(j = 0; j < T_COUNT; j++) {
+      for(cf = 0; cf < CF_COUNT; cf++) {
+         slot_free(&jobs[j].rra[cf]);
+         jobs[j].rra[cf].failed = 0;
+         jobs[j].rra[cf].from = 0;
+         jobs[j].rra[cf].till = 0;
+         jobs[j].rra[cf].tfetch = 0.0;
+         jobs[j].rra[cf].nrows = 0;
       }
+      jobs[j].tables = 0;
+   }
+   free(dcache);
+   dcache = NULL;
+   dc_cnt = 0;
+   dc_size = 0;
+   dc_changed = 0;
+   arch_cnt = -1;
+   ds_cnt = -1;
+}
+
+/* ------------------------------------------------------------ *
+ * cache_fill() adds the days tfrom..tto that are missing in    *
+ * the cache. The rows are fetched with the given step, from    *
+ * the first missing day up to tend. The days go through the    *
+ * energy report in runs of up to AGG_MAXCOL days. Days without *
+ * RRD data are not cached, they stay N/A. A daily row is a UTC *
+ * day, it goes to the local day that holds its middle (noon    *
+ * UTC). That is the UTC day of the same date, so the cache key *
+ * is right, but the total is offset by the time zone from the  *
+ * local day, like in the year table. Only the days before the  *
+ * hourly rows (12 months) are filled from daily rows.          *
+ * return code: 0 = success, -1 on error, see agg_run()         *
+ * ------------------------------------------------------------ */
+int cache_fill(struct slot *rra, time_t tfrom, time_t tto, time_t tend, unsigned long step) {
+   time_t bound[AGG_MAXCOL + 1];
+   double ppv[AGG_MAXCOL], bal[AGG_MAXCOL], yld[AGG_MAXCOL];
+   unsigned long steps[CF_COUNT] = { step, step };
+   time_t tday = tfrom;
+   char date[26];
+   int c, n;
+
+   while(tday < tto) {
+      while(tday < tto && cache_has(date_key(tday))) tday = next_day(tday);
+      if(tday >= tto) return(0);
+      if(verbose == 1) printf("Debug: daily totals cache fill from %s", ctime_r(&tday, date));
+
+      bound[0] = tday;
+      for(n = 0; n < AGG_MAXCOL && bound[n] < tto; n++) bound[n+1] = next_day(bound[n]);
+      if(energy_cols(rra, bound, n, tend, steps, 0, ppv, bal, yld) != 0) return(-1);
+      for(c = 0; c < n; c++)
+         if(! isnan(ppv[c]) && ! isnan(bal[c]))
+            cache_add(date_key(bound[c]), ppv[c], bal[c], yld[c]);
+      tday = bound[n];
+   }
+   return(0);
+}
+
+/* ------------------------------------------------------------ *
+ * cache_pv() is the PV energy of cached day i, with the daily  *
+ * yield picked like energy_cols() with useyld. Day, month and  *
+ * year cells all take it, so that a month is the sum of its    *
+ * day cells.                                                   *
+ * ------------------------------------------------------------ */
+double cache_pv(int i) {
+   return(pick_yield(dcache[i].yld, dcache[i].ppv));
+}
+
+/* ------------------------------------------------------------ *
+ * cache_day() gets a day table cell from the cache.            *
+ * return code: 0 = success, -1 if the day is not cached        *
+ * ------------------------------------------------------------ */
+int cache_day(time_t tday, double *ppv, double *bal) {
+   int key = date_key(tday);
+   int i = cache_find(key);
+   if(i == dc_cnt || dcache[i].date != key) return(-1);
 
-      /* print the solar power values before processing the next day */
-      if(ppvday >= 0.0) {
-         /* Highlight days with a negative balance */
-         if(balday > 0.0) fprintf(html, "   <td class=\"datacell\">");
-         else fprintf(html, "   <td class=\"minuscell\">");
-
-         /* Print the daily power generation */
-         if(ppvday >= 1000.0)
-            fprintf(html, "%.1f&thinsp;KW", ppvday/1000.0);
-         else
-            fprintf(html, "%.1f&thinsp;W", ppvday);
-
-         fprintf(html, " <br> ");
-         /* Print the daily power balance */
-         if((balday >= 1000.0) || (balday <= -1000.0))
-            fprintf(html, "%+.1f&thinsp;KW</td>\n", balday/1000.0);
-         else
-            fprintf(html, "%+.1f&thinsp;W</td>\n", balday);
+   *ppv = cache_pv(i);
+   *bal = dcache[i].bal;
+   return(0);
+}
+
+/* ------------------------------------------------------------ *
+ * cache_cell() gets a month or year table cell t1..t2 as sum   *
+ * of its cached days. Days from tfin on are not finished, they *
+ * come from the hourly rows of tfin..tsnow.                    *
+ * return code: 0 = success, -1 if the cache misses a day, or   *
+ * the hourly rows fail                                         *
+ * ------------------------------------------------------------ */
+int cache_cell(struct slot *rra, time_t t1, time_t t2, time_t tsnow, double *ppv, double *bal) {
+   time_t tf = (t2 < tfin) ? t2 : tfin;
+   int days = 0;
+
+   if(strlen(cachefile) == 0) return(-1);
+   *ppv = 0.0;
+   *bal = 0.0;
+
+   if(tf > t1) {
+      int key2 = date_key(tf);
+      int i = cache_find(date_key(t1));
+      for(; i < dc_cnt && dcache[i].date < key2; i++, days++) {
+         *ppv = *ppv + cache_pv(i);
+         *bal = *bal + dcache[i].bal;
       }
-      else  fprintf(html, "   <td class=\"emptycell\">N/A</td>\n");
+      if(days != (tf - t1 + 43200) / 86400) return(-1);   // DST days are 23h or 25h
+   }
+
+   if(t2 > tfin) {
+      static const unsigned long hourly[CF_COUNT] = { 3600, 3600 };
+      time_t bound[2] = { (t1 > tfin) ? t1 : tfin, t2 };
+      double ppvnow, balnow, yld;
+      if(energy_cols(rra, bound, 1, tsnow, hourly, 1, &ppvnow, &balnow, &yld) != 0) return(-1);
+      *ppv = *ppv + ppvnow;
+      *bal = *bal + balnow;
+   }
+   return(0);
+}
+
+void year_headhtml(outbuf *ob, int year){
+   ob_printf(ob, "<tr><td colspan=12 class=\"monthhead\">Yearly %s</td></tr>\n", report_title[report]);
+   ob_printf(ob, "<tr>\n");
+
+   /* ------------------------------------------------------------- *
+    *  Cycle through the 12 year history columns, oldest first      *
+    * ------------------------------------------------------------- */
+   int i;
+   for(i = 11; i >= 0; i--) {
+      /* ------------------------------------------------------------- *
+       * Create the header row for individual months                   *
+       * ------------------------------------------------------------- */
+      int show_year = year - i;
+      if(verbose == 1) printf("Debug: show year=%d\n", show_year);
+      ob_printf(ob, "   <td class=\"monthcell\">%d</td>\n", show_year);
    }
+   ob_printf(ob, "</tr>\n");
 }
 
-void month_headhtml(int mon, int year){
-   fprintf(html, "<tr><td colspan=12 class=\"monthhead\">Monthly Power Generation and Energy Balance +/-</td></tr>\n");
-   fprintf(html, "<tr>\n");
+void month_headhtml(outbuf *ob, int mon, int year){
+   ob_printf(ob, "<tr><td colspan=12 class=\"monthhead\">Monthly %s</td></tr>\n", report_title[report]);
+   ob_printf(ob, "<tr>\n");
 
    /* ------------------------------------------------------------- *
     *  Cycle through the 12 month history columns, oldest first     *
@@ -281,232 +1346,397 @@ void month_headhtml(int mon, int year){
        * ------------------------------------------------------------- */
       char yearstr[5];
       snprintf(yearstr, sizeof(yearstr), "%d", show_year);
-      fprintf(html, "   <td class=\"monthcell\">%.3s %s</td>\n", mon_name[show_mon-1], yearstr+2);
+      ob_printf(ob, "   <td class=\"monthcell\">%.3s %s</td>\n", mon_name[show_mon-1], yearstr+2);
    }
-   fprintf(html, "</tr>\n");
+   ob_printf(ob, "</tr>\n");
 }
 
-void month_datahtml(int mon, int year, time_t ts){
-   int i, j, k = 0;
-   unsigned long step = 86400;
+void day_headhtml(outbuf *ob, time_t tsnow){
    /* ------------------------------------------------------------- *
-    *  Create the data row for min max values to display            *
+    * Create html table and main header row                         *
     * ------------------------------------------------------------- */
-   fprintf(html, "<tr>\n");
-   for(i = 11; i >= 0; i--) {
-      int show_mon = mon - i;
-      int show_year = year;
-      if (show_mon == 0) { show_mon = 12; show_year = year-1; }
-      if (show_mon < 0) { show_mon = show_mon+12; show_year = year-1; }
-      /* ------------------------------------------------------------- *
-       * Create the start timestamp for rrd fetch, 1st day of month.   *
-       * ------------------------------------------------------------- */
-      struct tm start_tm;
-      start_tm.tm_year = show_year-1900;
-      start_tm.tm_mon  = show_mon-1;
-      start_tm.tm_mday = 1;
-      start_tm.tm_hour = 0;
-      start_tm.tm_min  = 0;
-      start_tm.tm_sec  = 0;
-
-      time_t tstart = mktime(&start_tm);
-      if(tstart == -1) printf("Error");
-      if(verbose == 1) printf("Debug: ts=%lld start date=%s", (long long) tstart, ctime(&tstart));
+   ob_printf(ob, "<tr><td colspan=12 class=\"monthhead\">Daily %s</td></tr>\n", report_title[report]);
+   ob_printf(ob, "<tr>\n");
 
-      /* ------------------------------------------------------------- *
-       * Create the end timestamp for rrd fetch, 1st day of next month *
-       * ------------------------------------------------------------- */
-      struct tm end_tm;
-      end_tm.tm_year = show_year-1900;
-      end_tm.tm_mon  = show_mon;
-      end_tm.tm_mday = 1;
-      end_tm.tm_hour = 0;
-      end_tm.tm_min  = 0;
-      end_tm.tm_sec  = -1;
-
-      time_t tend = mktime(&end_tm);
-      if(tend == -1) printf("Error creating RRD timerange timestamp tend.");
-      if(tend > ts) tend = ts; // if we are at the current month, end at now time
-      if(verbose == 1) printf("Debug: ts=%lld end date=%s", (long long) tend, ctime(&tend));
+   /* ------------------------------------------------------------- *
+    *  Cycle through the 12 days history columns, oldest first      *
+    * ------------------------------------------------------------- */
+   time_t tshow = tsnow - (86400*12);
+   int i;
+   for(i = 0; i<12; i++) {
+      struct tm show_tm;
+      localtime_r(&tshow, &show_tm);
+      if(verbose == 1) printf("Debug: show day=%.3s-%d\n", mon_name[show_tm.tm_mon], show_tm.tm_mday);
+      ob_printf(ob, "   <td class=\"monthcell\">%.3s %d</td>\n", mon_name[show_tm.tm_mon], show_tm.tm_mday);
+      tshow = tshow + 86400;
+   }
+   ob_printf(ob, "</tr>\n");
+   if(verbose == 1) printf("Debug: Finished html date row\n");
+}
 
-      /* ------------------------------------------------------------- *
-       * rrd_fetch_r() gets all RRD values for a specific time range.  *
-       * 8x function args: 5x input, 3x output. Returns 0 for success. *
-       * (1) const char *filename,                                     *
-       * (2) const char *consolidation_function,                       *
-       * (3) time_t *start,                                            *
-       * (4) time_t *end,                                              *
-       * (5) unsigned long *step,                                      *
-       * (6) unsigned long *ds_cnt,                                    *
-       * (7) char ***ds_namv,                                          *
-       * (8) rrd_value_t **data);                                      *
-       * ------------------------------------------------------------- */
-      int ret = rrd_fetch_r(rrdfile, "AVERAGE", &tstart, &tend, &step, &ds_cnt, &ds_namv, &rrddata);
-      if (ret != 0) { printf("Error: cannot fetch data from RRD.\n"); exit(-1); }
-      if(verbose == 1) printf("Debug: min rrd_fetch_r return=%d, ds count=%lu\n", ret, ds_cnt);
+/* ------------------------------------------------------------ *
+ * The row step per table and RRA, the coarsest rows a table   *
+ * can use, see plan_rows(). Day and month table need hourly    *
+ * rows, so the columns match local midnight. The hourly RRA    *
+ * does not reach back far enough for 12 years, so the year     *
+ * table takes daily rows. They are UTC days, and the year      *
+ * boundary is off by the local UTC offset.                     *
+ * ------------------------------------------------------------ */
+static const unsigned long table_step[T_COUNT][CF_COUNT] = {
+   { 3600,  3600,  0 },            // T_DAY:  AVERAGE, MAX, MIN
+   { 3600,  3600,  0 },            // T_MON
+   { 86400, 86400, 0 },            // T_YEAR
+};
 
-      k=0;
-      int days = ((tend - tstart) / 86400)-1;
-      if(verbose == 1) printf("Debug: result day count=%d\n", days);
+/* ------------------------------------------------------------ *
+ * table_bounds() creates the 13 column bounds of a table, the  *
+ * local midnights, oldest column first. It returns the end of  *
+ * the table: the day table ends with yesterday, month and year *
+ * end at now.                                                  *
+ * ------------------------------------------------------------ */
+time_t table_bounds(int type, time_t tsnow, time_t *bound) {
+   struct tm now;
+   char date[26];
+   int i;
 
-      /* ------------------------------------------------------------- *
-       * Go through the returned dataset. For PPV, create sum of daily *
-       * power intake, divide by 24 to get the (Kilo) Watt hour value. *
-       * For balance, the battery current is pos/neg per power surplus *
-       * creating the pos/neg power value when multiplied with voltage *
-       * The set size is 12 days * 24 hrs (60 mins) * 6 data sources:  *
-       * pv watt=ds_namv[3], bat volts=ds_namv[0], bat cur=ds_namv[1]  *
-       * ------------------------------------------------------------- */
-      double ppvday = 0.0;
-      double balday = 0.0;
-
-      for(j=0; j<(days*ds_cnt); j=j+ds_cnt) {
-         k++;
-         if(verbose == 1) printf("Debug: day [%d] value [%d] rrd_fetch_r [%s:%.2f] [%s:%.2f] [%s:%.2f]\n",
-                                  k, j, ds_namv[3], rrddata[j+3], ds_namv[0], rrddata[j], ds_namv[1], rrddata[j+1]);
-         /* since the data is a 24hr avg, we multiply by 24 to get the approx. Watt number */
-         if(! isnan(rrddata[j+3])) ppvday = ppvday + (rrddata[j+3] * 24);
-         if(! isnan(rrddata[j]) && ! isnan(rrddata[j+1])) balday = balday + ((rrddata[j] * rrddata[j+1]) * 24);
+   localtime_r(&tsnow, &now);
+   for(i = 0; i <= 12; i++) {
+      if(type == T_DAY)  bound[i] = day_start(tsnow, i);
+      if(type == T_MON)  bound[i] = month_start(now.tm_mon + 1, now.tm_year + 1900, i);
+      if(type == T_YEAR) bound[i] = year_start(now.tm_year + 1900, i);
+   }
+   time_t tend = (type == T_DAY) ? bound[12] : tsnow;
+   if(verbose == 1) printf("Debug: ts=%lld start date=%s", (long long) bound[0], ctime_r(&bound[0], date));
+   if(verbose == 1) printf("Debug: ts=%lld end date=%s", (long long) tend, ctime_r(&tend, date));
+   return(tend);
+}
+
+/* ------------------------------------------------------------ *
+ * energy_table() computes an energy table, PV energy ppv and   *
+ * battery balance bal [Wh] per column. Cells come from the     *
+ * daily totals cache if we have one, the others from the       *
+ * energy report over all 12 columns.                           *
+ * return code: 0 = success, -1 on error, see agg_run()         *
+ * ------------------------------------------------------------ */
+static const char *energy_name[] = { "ppv", "bal" };
+
+int energy_table(struct slot *rra, int type, time_t tsnow, struct table *t) {
+   double *ppv = t->v, *bal = t->v + 12;
+   double yld[12], ppvrep[12], balrep[12];
+   int i, done[12], missing = 0;
+
+   t->type = type;
+   t->ncol = 12;
+   t->tend = table_bounds(type, tsnow, t->bound);
+   t->nval = 2;
+   t->name = energy_name;
+
+   for(i = 0; i < 12; i++) {
+      if(type == T_DAY)
+         done[i] = (t->bound[i+1] <= tfin && cache_day(t->bound[i], &ppv[i], &bal[i]) == 0);
+      else
+         done[i] = (cache_cell(rra, t->bound[i], (t->bound[i+1] > tsnow) ? tsnow : t->bound[i+1],
+                               tsnow, &ppv[i], &bal[i]) == 0);
+      if(done[i] == 0) missing++;
+   }
+
+   if(missing > 0) {
+      if(energy_cols(rra, t->bound, 12, t->tend, table_step[type], (type == T_DAY),
+                     ppvrep, balrep, yld) != 0) return(-1);
+      for(i = 0; i < 12; i++) {
+         if(done[i] == 1) continue;
+         ppv[i] = ppvrep[i];
+         bal[i] = balrep[i];
       }
+   }
+   return(0);
+}
+
+/* ------------------------------------------------------------ *
+ * The min/max report reads the MIN and MAX RRAs, one fetch of  *
+ * each per table for all three DS. The day and month table     *
+ * use the hourly rows, which match local midnight and reach    *
+ * back 550 days. The year table has daily (UTC) rows.          *
+ * ------------------------------------------------------------ */
+static const struct aggspec minmax_spec[] = {
+   { CF_MIN, "vbat", NULL, R_MIN }, { CF_MAX, "vbat", NULL, R_MAX },
+   { CF_MIN, "vpnl", NULL, R_MIN }, { CF_MAX, "vpnl", NULL, R_MAX },
+   { CF_MIN, "ibat", NULL, R_MIN }, { CF_MAX, "ibat", NULL, R_MAX },
+};
+static const char *minmax_name[]  = { "vbat_min", "vbat_max", "vpnl_min",
+                                      "vpnl_max", "ibat_min", "ibat_max" };
+static const char *minmax_label[] = { "Battery Voltage", "Panel Voltage", "Battery Current" };
+static const char *minmax_unit[]  = { "V", "V", "A" };
+static const unsigned long minmax_step[T_COUNT][CF_COUNT] = {
+   { 0, 3600,  3600 },             // T_DAY:  AVERAGE, MAX, MIN
+   { 0, 3600,  3600 },             // T_MON
+   { 0, 86400, 86400 },            // T_YEAR
+};
 
-      /* print the solar power values before processing the next day */
-      if(ppvday >= 0.0) {
-         /* Highlight days with a negative balance */
-         if(balday > 0.0) fprintf(html, "   <td class=\"datacell\">");
-         else fprintf(html, "   <td class=\"minuscell\">");
+int minmax_table(struct slot *rra, int type, time_t tsnow, struct table *t) {
+   t->type = type;
+   t->ncol = 12;
+   t->tend = table_bounds(type, tsnow, t->bound);
+   t->nval = 6;
+   t->name = minmax_name;
+   return(agg_run(rra, minmax_spec, 6, t->bound, 12, t->tend, minmax_step[type], t->v));
+}
+
+/* ------------------------------------------------------------ *
+ * print_minmax() writes one table cell with the lowest and the *
+ * highest value of a column.                                   *
+ * ------------------------------------------------------------ */
+void print_minmax(outbuf *ob, double min, double max, const char *unit) {
+   if(isnan(min) || isnan(max))
+      ob_printf(ob, "   <td class=\"emptycell\">N/A</td>\n");
+   else
+      ob_printf(ob, "   <td class=\"datacell\">%.2f&thinsp;%s <br> %.2f&thinsp;%s</td>\n",
+                min, unit, max, unit);
+}
 
-         if(ppvday >= 1000.0)
-            fprintf(html, "%.1f&thinsp;KW", ppvday/1000.0);
-         else
-            fprintf(html, "%.1f&thinsp;W", ppvday);
+/* ------------------------------------------------------------ *
+ * table_html() writes the html table: the header rows, and the *
+ * data row of the energy table, or a label row and a data row  *
+ * per DS of the min/max table.                                 *
+ * ------------------------------------------------------------ */
+void table_html(outbuf *ob, const struct table *t, time_t tsnow, int this_mon, int this_year) {
+   int d, i;
 
-         fprintf(html, " <br> ");
+   ob_printf(ob, "<table class=\"dmovtable\">\n");
+   if(t->type == T_DAY)  day_headhtml(ob, tsnow);
+   if(t->type == T_MON)  month_headhtml(ob, this_mon, this_year);
+   if(t->type == T_YEAR) year_headhtml(ob, this_year);
 
-         if((balday >= 1000.0) || (balday <= -1000.0))
-            fprintf(html, "%+.1f&thinsp;KW</td>\n", balday/1000.0);
-         else
-            fprintf(html, "%+.1f&thinsp;W</td>\n", balday);
+   if(report == REP_ENERGY) {
+      ob_printf(ob, "<tr>\n");
+      for(i = 0; i < 12; i++) print_energy(ob, t->v[i], t->v[12 + i]);
+      ob_printf(ob, "</tr>\n");
+   }
+   if(report == REP_MINMAX) {
+      for(d = 0; d < 3; d++) {
+         ob_printf(ob, "<tr><td colspan=12 class=\"monthhead\">%s</td></tr>\n", minmax_label[d]);
+         ob_printf(ob, "<tr>\n");
+         for(i = 0; i < 12; i++)
+            print_minmax(ob, t->v[2 * d * 12 + i], t->v[(2 * d + 1) * 12 + i], minmax_unit[d]);
+         ob_printf(ob, "</tr>\n");
       }
-      else  fprintf(html, "   <td class=\"emptycell\">N/A</td>\n");
    }
+   ob_printf(ob, "</table>\n");
+   if(verbose == 1) printf("Debug: Finished html value row\n");
 }
 
-void day_headhtml(time_t tsnow){
-   /* ------------------------------------------------------------- *
-    * Create html table and main header row                         *
-    * ------------------------------------------------------------- */
-   fprintf(html, "<tr><td colspan=12 class=\"monthhead\">Daily Power Generation and Energy Balance +/-</td></tr>\n");
-   fprintf(html, "<tr>\n");
+/* ------------------------------------------------------------ *
+ * table_data() writes the table as CSV or JSON: one line or    *
+ * object per column with start and end time (Unix seconds),    *
+ * the local date of the start, and the values by name. Energy  *
+ * values are in Wh, voltage in V and current in A. Values the  *
+ * RRD has no data for are empty in CSV and null in JSON. The   *
+ * range report writes its columns in runs, with data_head(),   *
+ * data_cols() per run, and data_tail().                        *
+ * ------------------------------------------------------------ */
+void data_head(outbuf *ob, int type, int nval, const char **name) {
+   int n;
 
-   /* ------------------------------------------------------------- *
-    *  Cycle through the 12 days history columns, oldest first      *
-    * ------------------------------------------------------------- */
-   time_t tshow = tsnow - (86400*12);
-   int i;
-   for(i = 0; i<12; i++) {
-      struct tm show_tm = * localtime(&tshow);   // now
-      if(verbose == 1) printf("Debug: show day=%.3s-%d\n", mon_name[show_tm.tm_mon], show_tm.tm_mday);
-      fprintf(html, "   <td class=\"monthcell\">%.3s %d</td>\n", mon_name[show_tm.tm_mon], show_tm.tm_mday);
-      tshow = tshow + 86400;
+   if(outfmt == FMT_JSON) {
+      ob_printf(ob, "{\"table\":\"%s\",\"report\":\"%s\",", table_name[type],
+                (report == REP_ENERGY) ? "energy" : "minmax");
+      if(type == T_RANGE) ob_printf(ob, "\"group\":\"%s\",", group_name[group]);
+      ob_printf(ob, "\"columns\":[");
+   }
+   else {
+      ob_printf(ob, "start,end,date");
+      for(n = 0; n < nval; n++) ob_printf(ob, ",%s", name[n]);
+      ob_printf(ob, "\n");
    }
-   fprintf(html, "</tr>\n");
-   if(verbose == 1) printf("Debug: Finished html date row\n");
 }
 
-void day_datahtml(time_t tsnow) {
-   unsigned long step = 3600;
-   /* ------------------------------------------------------------- *
-    *  Create the data row for power values to display              *
-    * ------------------------------------------------------------- */
-   time_t tstart = tsnow - (86400 * 12);
-   if(verbose == 1) printf("Debug: Create html value row\n");
-   if(verbose == 1) printf("Debug: ts=%lld now date=%s", (long long) tsnow, ctime(&tsnow));
-   if(verbose == 1) printf("Debug: ts=%lld start date=%s", (long long) tstart, ctime(&tstart));
+void data_cols(outbuf *ob, const struct table *t, int first) {
+   static const char *datefmt[T_COUNT] = { "%Y-%m-%d", "%Y-%m", "%Y" };
+   struct tm col_tm;
+   char date[32];
+   int c, n;
 
-   struct tm start_tm = * localtime(&tstart);   // now-12 days
-   start_tm.tm_hour = 0;
-   start_tm.tm_min  = 0;
-   start_tm.tm_sec  = 0;
-   tstart = mktime(&start_tm);
-   if(tstart == -1) printf("Error creating tstart timestamp for day_datahtml");
-   if(verbose == 1) printf("Debug: ts=%lld start date=%s", (long long) tstart, ctime(&tstart));
+   for(c = 0; c < t->ncol; c++) {
+      time_t tnext = (t->bound[c+1] < t->tend) ? t->bound[c+1] : t->tend;
+      if(t->type == T_RANGE) group_label(t->bound[c], group, date, sizeof(date));
+      else strftime(date, sizeof(date), datefmt[t->type], localtime_r(&t->bound[c], &col_tm));
 
-   struct tm end_tm = * localtime(&tsnow);   // now
-   end_tm.tm_hour = 0;
-   end_tm.tm_min  = 0;
-   end_tm.tm_sec  = 0;
-   time_t tend = mktime(&end_tm);
-   //time_t tend = tsnow;
-   if(tend == -1) printf("Error creating tend timestamp for day_datahtml");
-   if(verbose == 1) printf("Debug: ts=%lld end date=%s", (long long) tend, ctime(&tend));
+      if(outfmt == FMT_JSON)
+         ob_printf(ob, "%s{\"start\":%lld,\"end\":%lld,\"date\":\"%s\"",
+                   (c == 0 && first == 1) ? "" : ",", (long long) t->bound[c], (long long) tnext, date);
+      else
+         ob_printf(ob, "%lld,%lld,%s", (long long) t->bound[c], (long long) tnext, date);
 
-   /* ------------------------------------------------------------- *
-    * rrd_fetch_r() gets all RRD values for a specific time range.  *
-    * 8x function args: 5x input, 3x output. Returns 0 for success. *
-    * (1) const char *filename,                                     *
-    * (2) const char *consolidation_function,                       *
-    * (3) time_t *start,                                            *
-    * (4) time_t *end,                                              *
-    * (5) unsigned long *step,                                      *
-    * (6) unsigned long *ds_cnt,                                    *
-    * (7) char ***ds_namv,                                          *
-    * (8) rrd_value_t **data);                                      *
-    * ------------------------------------------------------------- */
-   int ret = rrd_fetch_r(rrdfile, "AVERAGE", &tstart, &tend, &step, &ds_cnt, &ds_namv, &rrddata);
-   if (ret != 0) { printf("Error: cannot fetch data from RRD.\n"); exit(-1); }
-   if(verbose == 1) printf("Debug: min rrd_fetch_r return=%d, ds count=%lu\n", ret, ds_cnt);
+      for(n = 0; n < t->nval; n++) {
+         double v = t->v[n * t->ncol + c];
+         if(outfmt == FMT_JSON) {
+            if(isnan(v)) ob_printf(ob, ",\"%s\":null", t->name[n]);
+            else ob_printf(ob, ",\"%s\":%.10g", t->name[n], v);
+         }
+         else {
+            if(isnan(v)) ob_printf(ob, ",");
+            else ob_printf(ob, ",%.10g", v);
+         }
+      }
+      ob_printf(ob, (outfmt == FMT_JSON) ? "}" : "\n");
+   }
+}
 
-   fprintf(html, "<tr>\n");
+void data_tail(outbuf *ob) {
+   if(outfmt == FMT_JSON) ob_printf(ob, "]}\n");
+}
 
-   int i, j=0, k=0;
-   double ppvday = 0.0;
-   double balday = 0.0;
-      /* ------------------------------------------------------------- *
-       * Go through the returned dataset. For PPV, create sum of daily *
-       * power intake, divide by 24 to get the (Kilo) Watt hour value. *
-       * For balance, the battery current is pos/neg per power surplus *
-       * creating the pos/neg power value when multiplied with voltage *
-       * The set size is 12 days * 24 hrs (60 mins) * 6 data sources:  *
-       * pv watt=ds_namv[3], bat volts=ds_namv[0], bat cur=ds_namv[1]  *
-       * ------------------------------------------------------------- */
-   for(i=0; i<(288*ds_cnt); i=i+ds_cnt) {
-
-      if(verbose == 1) printf("Debug: day [%2d] hour [%2d] %s [%.2f] %s [%.2f] %s [%.2f]\n",
-                               k, j, ds_namv[3], rrddata[i+3], ds_namv[0],  rrddata[i], ds_namv[1],  rrddata[i+1]);
-      if(! isnan(rrddata[i+3])) ppvday = ppvday + rrddata[i+3];
-      if(! isnan(rrddata[i]) && ! isnan(rrddata[i+1])) balday = balday + (rrddata[i] * rrddata[i+1]);
-      j++;
-      if(j==24) {
-         k++; j=0;
-
-         if(verbose == 1) printf("Debug: day [%2d] %s [%.2f] balance [%.2f]\n",
-                               k-1, ds_namv[3], ppvday, balday);
-         /* print the solar power values before processing the next day */
-         if(ppvday >= 0.0) {
-            /* Highlight days with a negative balance */
-            if(balday > 0.0) fprintf(html, "   <td class=\"datacell\">");
-            else fprintf(html, "   <td class=\"minuscell\">");
-
-            if(ppvday >= 1000.0)
-               fprintf(html, "%.1f&thinsp;KW", ppvday/1000.0);
-            else
-               fprintf(html, "%.1f&thinsp;W", ppvday);
+void table_data(outbuf *ob, const struct table *t) {
+   data_head(ob, t->type, t->nval, t->name);
+   data_cols(ob, t, 1);
+   data_tail(ob);
+}
 
-            fprintf(html, " <br> ");
-            /* print the balance values before processing the next day */
-            if((balday >= 1000.0) || (balday <= -1000.0))
-               fprintf(html, "%+.1f&thinsp;KW</td>\n", balday/1000.0);
-            else
-               fprintf(html, "%+.1f&thinsp;W</td>\n", balday);
-         }
-         else  fprintf(html, "   <td class=\"emptycell\">N/A</td>\n");
+/* ------------------------------------------------------------ *
+ * render_table() computes one table from the rows of rra, and  *
+ * builds its output file in out[type], type is T_DAY etc.      *
+ * return code: 0 = success, -1 on error, see agg_run()         *
+ * ------------------------------------------------------------ */
+int render_table(struct slot *rra, int type, time_t tsnow) {
+   struct mark m = { 0 };
+   struct tm now;
+   struct table t;
+   int ret = 0;
+
+   phase_mark(&m, rra, type, P_REDUCE);
+   localtime_r(&tsnow, &now);
+   if(report == REP_ENERGY) ret = energy_table(rra, type, tsnow, &t);
+   if(report == REP_MINMAX) ret = minmax_table(rra, type, tsnow, &t);
+   phase_mark(&m, rra, type, P_REDUCE);
+   if(ret != 0) return(-1);
 
-         /* Reset the values before processing the next day */
-         ppvday = 0.0;
-         balday = 0.0;
+   ob_clear(&out[type]);
+   if(outfmt == FMT_HTML) table_html(&out[type], &t, tsnow, now.tm_mon + 1, now.tm_year + 1900);
+   else table_data(&out[type], &t);
+   phase_mark(&m, rra, type, P_RENDER);
+   return(0);
+}
+
+/* ------------------------------------------------------------ *
+ * range_html() writes the html rows of a range report, one row *
+ * per group, as the columns of long reports don't fit across.  *
+ * ------------------------------------------------------------ */
+void range_html(outbuf *ob, const struct table *t) {
+   char label[32];
+   int c, d;
+
+   for(c = 0; c < t->ncol; c++) {
+      group_label(t->bound[c], group, label, sizeof(label));
+      ob_printf(ob, "<tr>\n   <td class=\"monthcell\">%s</td>\n", label);
+      if(report == REP_ENERGY) print_energy(ob, t->v[c], t->v[t->ncol + c]);
+      if(report == REP_MINMAX)
+         for(d = 0; d < 3; d++)
+            print_minmax(ob, t->v[2 * d * t->ncol + c], t->v[(2 * d + 1) * t->ncol + c],
+                         minmax_unit[d]);
+      ob_printf(ob, "</tr>\n");
+   }
+}
+
+/* ------------------------------------------------------------ *
+ * render_range() creates the range report -f..-t, grouped by   *
+ * -g, in out[T_RANGE]. The first column starts at -f, the      *
+ * others at group bounds, the last one ends at -t or now. The  *
+ * rows of the whole range are fetched once, planned with       *
+ * from..till, then the columns go through the report in runs   *
+ * of up to AGG_MAXCOL. Groups of a day up to a season need     *
+ * hourly rows for local midnight, years take the daily rows    *
+ * like the year table. Ranges beyond the hourly RRA get the    *
+ * daily rows for their older part, see plan_rows().            *
+ * return code: 0 = success, -1 on error, see agg_run()         *
+ * ------------------------------------------------------------ */
+int render_range(struct slot *rra, time_t tsnow) {
+   static const char *dsname[] = { "", "Battery Voltage", "Panel Voltage", "Battery Current" };
+   unsigned long s = (group == G_YEAR) ? 86400 : 3600;
+   const unsigned long step[CF_COUNT] = { s, s, s };
+   time_t tto = (qto > 0 && qto < tsnow) ? qto : tsnow;
+   time_t tb = qfrom;
+   outbuf *ob = &out[T_RANGE];
+   double yld[AGG_MAXCOL];
+   struct mark m = { 0 };
+   struct table t;
+   char date[26];
+   int cf, d, ret = 0, first = 1;
+
+   phase_mark(&m, rra, T_RANGE, P_RENDER);
+   ob_clear(ob);
+   for(cf = 0; cf < CF_COUNT; cf++) {
+      rra[cf].from = qfrom;
+      rra[cf].till = tto;
+   }
+
+   t.type = T_RANGE;
+   t.nval = (report == REP_ENERGY) ? 2 : 6;
+   t.name = (report == REP_ENERGY) ? energy_name : minmax_name;
+   if(outfmt != FMT_HTML) data_head(ob, T_RANGE, t.nval, t.name);
+   else {
+      ob_printf(ob, "<table class=\"dmovtable\">\n");
+      ob_printf(ob, "<tr><td colspan=%d class=\"monthhead\">%s %s</td></tr>\n",
+                (report == REP_ENERGY) ? 2 : 4, group_title[group], report_title[report]);
+      if(report == REP_MINMAX) {
+         ob_printf(ob, "<tr>\n");
+         for(d = 0; d < 4; d++) ob_printf(ob, "   <td class=\"monthcell\">%s</td>\n", dsname[d]);
+         ob_printf(ob, "</tr>\n");
       }
    }
-   if(verbose == 1) printf("Debug: Finished html value row\n");
+
+   while(tb < tto) {
+      t.ncol = 0;
+      t.bound[0] = tb;
+      while(t.ncol < AGG_MAXCOL && t.bound[t.ncol] < tto) {
+         t.bound[t.ncol + 1] = group_end(t.bound[t.ncol], group);
+         t.ncol++;
+      }
+      t.tend = (t.bound[t.ncol] < tto) ? t.bound[t.ncol] : tto;
+      if(verbose == 1) printf("Debug: range columns %d from %s", t.ncol, ctime_r(&t.bound[0], date));
+
+      if(report == REP_ENERGY)
+         ret = energy_cols(rra, t.bound, t.ncol, t.tend, step, (group == G_DAY), t.v, t.v + t.ncol, yld);
+      if(report == REP_MINMAX)
+         ret = agg_run(rra, minmax_spec, 6, t.bound, t.ncol, t.tend, step, t.v);
+      phase_mark(&m, rra, T_RANGE, P_REDUCE);
+      if(ret != 0) return(-1);
+
+      if(outfmt == FMT_HTML) range_html(ob, &t);
+      else data_cols(ob, &t, first);
+      phase_mark(&m, rra, T_RANGE, P_RENDER);
+      first = 0;
+      tb = t.bound[t.ncol];
+   }
+
+   if(outfmt == FMT_HTML) ob_printf(ob, "</table>\n");
+   else data_tail(ob);
+   phase_mark(&m, rra, T_RANGE, P_RENDER);
+   return(0);
+}
+
+/* ------------------------------------------------------------ *
+ * run_job() renders the tables of a job, from its own rows. It *
+ * runs as a thread per job, see main(). Jobs share nothing but *
+ * the read-only RRA list and daily totals cache, each table    *
+ * has its own out[] buffer. A thread must not exit(), so a     *
+ * failed table ends the job with status -1, and main() exits   *
+ * after it joined all threads.                                 *
+ * ------------------------------------------------------------ */
+void *run_job(void *arg) {
+   struct job *j = arg;
+   int type, ret;
+
+   j->status = 0;
+   for(type = 0; type < T_COUNT; type++) {
+      if(! (j->tables & (1 << type))) continue;
+      if(type == T_RANGE) ret = render_range(j->rra, j->tsnow);
+      else ret = render_table(j->rra, type, j->tsnow);
+      if(ret != 0) {
+         j->status = -1;
+         break;
+      }
+   }
+   return(NULL);
 }
 
 int main(int argc, char *argv[]) {
@@ -514,56 +1744,138 @@ int main(int argc, char *argv[]) {
     * Process the cmdline parameters                               *
     * ------------------------------------------------------------ */
    parseargs(argc, argv);
-   if(verbose == 1) printf("Debug: RRD file=%s\tHTM file=%s\n", rrdfile, htmfile);
+   if(verbose == 1) printf("Debug: RRD file=%s\tOutput files=%s|%s|%s|%s\n", rrdfile,
+                           outfile[T_DAY], outfile[T_MON], outfile[T_YEAR], outfile[T_RANGE]);
 
    /* ------------------------------------------------------------ *
     * get current time (now), and time 11 months back (start)      *
     * ------------------------------------------------------------ */
+   double tstart = clock_sec();
    time_t tsnow = time(NULL);
    struct tm now = * localtime(&tsnow);   // now
    int  this_mon = now.tm_mon + 1;        // tm_mon is 0..11
    int this_year = now.tm_year + 1900;    // tm_year is year since 1900
 
-   if(verbose == 1) printf("Debug: date=%s", ctime(&tsnow));
+   char date[26];
+   if(verbose == 1) printf("Debug: date=%s", ctime_r(&tsnow, date));
    if(verbose == 1) printf("Debug: start year-month=%d-%d\n", this_year, this_mon);
 
-   /* ----------------------------------------------------------- *
-    *  Open the html file for writing the table data              *
-    * ----------------------------------------------------------- */
-   if(! (html=fopen(htmfile, "w")))
-      printf("Error open %s for writing.\n", htmfile);
+   /* ------------------------------------------------------------ *
+    * Split the tables into jobs, the tables of a job share their  *
+    * rows. The day and month table read hourly rows, so the first *
+    * fetch of a slot covers the longer month range up to now, and *
+    * serves both tables. The year table needs daily rows, and the *
+    * range report its own range, they get a job each. With the    *
+    * daily totals cache, the tables only fetch today's hours and  *
+    * share one job.                                               *
+    * ------------------------------------------------------------ */
+   int want_day  = outtype & (1 << T_DAY);
+   int want_mon  = outtype & (1 << T_MON);
+   int want_year = outtype & (1 << T_YEAR);
+   if((outtype & (1 << T_RANGE)) && qfrom >= tsnow) {
+      printf("Error: Range report start -f is not before now, %s", ctime_r(&tsnow, date));
+      exit(-1);
+   }
+   int use_cache = (strlen(cachefile) > 0 && report == REP_ENERGY && (want_day || want_mon || want_year));
+   int job_of[T_COUNT] = { 0, 0, (use_cache) ? 0 : 1, 2 };
+   int cf, j, type, njob = 0;
 
-   fprintf(html, "<table class=\"dmovtable\">\n");
+   for(type = 0; type < T_COUNT; type++)
+      if(outtype & (1 << type)) jobs[job_of[type]].tables |= 1 << type;
+   for(j = 0; j < T_COUNT; j++) {
+      jobs[j].tsnow = tsnow;
+      for(cf = 0; cf < CF_COUNT; cf++) jobs[j].rra[cf].cf = cf_name[cf];
+      if(jobs[j].tables != 0) njob++;
+   }
+   struct mark m = { 0 };
+   phase_mark(&m, jobs[0].rra, T_COUNT, P_FETCH);
+   rrd_archives();                        // before the threads, they only read it
+   phase_mark(&m, jobs[0].rra, T_COUNT, P_FETCH);
 
    /* ------------------------------------------------------------ *
-    * If we received -d, create the daily html table data          *
+    * With the daily totals cache, add the days that finished      *
+    * since the last run. A day is final one hour after midnight,  *
+    * when the hourly row is complete. The hourly RRA holds the    *
+    * 12 month range, older days for the year table come from the  *
+    * daily rows. The tables then only fetch today's hours.        *
     * ------------------------------------------------------------ */
-   if(outtype == 1) {
-      day_headhtml(tsnow);
-      day_datahtml(tsnow);
+   if(use_cache) {
+      struct slot *rra = jobs[0].rra;
+      cache_load();
+      time_t today = day_start(tsnow, 12);
+      tfin = (tsnow - today >= 3600) ? today : day_start(tsnow, 11);
+
+      time_t thour = month_start(this_mon, this_year, 0);
+      time_t tfrom = day_start(tsnow, 0);
+      if(want_mon) tfrom = thour;
+      if(want_year) tfrom = year_start(this_year, 0);
+
+      for(cf = 0; cf < CF_COUNT; cf++) rra[cf].from = tfin;   // for today's hours
+      if((tfrom < thour && cache_fill(rra, tfrom, thour, thour, 86400) != 0) ||
+         cache_fill(rra, (tfrom > thour) ? tfrom : thour, tfin, tsnow, 3600) != 0) exit(-1);
+      phase_mark(&m, rra, T_COUNT, P_REDUCE);
+   }
+   else if(want_day && want_mon) {
+      for(cf = 0; cf < CF_COUNT; cf++) {
+         jobs[0].rra[cf].from = month_start(this_mon, this_year, 0);
+         jobs[0].rra[cf].till = tsnow;
+      }
    }
 
    /* ------------------------------------------------------------ *
-    * If we received -m, create the monthly html table data        *
+    * Render the jobs in parallel, one thread per job. If a thread *
+    * can't be created, its job runs here, next to the others. If  *
+    * a job failed, no file is written once all threads are done.  *
     * ------------------------------------------------------------ */
-   if(outtype == 2) {
-      month_headhtml(this_mon, this_year);
-      month_datahtml(this_mon, this_year, tsnow);
+   for(j = 0; j < T_COUNT; j++) {
+      if(jobs[j].tables == 0) continue;
+      if(njob > 1 && pthread_create(&jobs[j].thread, NULL, run_job, &jobs[j]) == 0)
+         jobs[j].started = 1;
+      else run_job(&jobs[j]);
+   }
+   int failed = 0;
+   for(j = 0; j < T_COUNT; j++) {
+      if(jobs[j].started == 1) pthread_join(jobs[j].thread, NULL);
+      jobs[j].started = 0;
+      if(jobs[j].tables != 0 && jobs[j].status != 0) failed = 1;
+   }
+   if(failed == 1) {
+      report_free();
+      for(type = 0; type < T_COUNT; type++) ob_free(&out[type]);
+      exit(-1);
    }
 
    /* ------------------------------------------------------------ *
-    * If we received -y, create the yearly html table data         *
+    * Write the files in the order day, month, year, range. If one *
+    * can't be written, stop without saving the cache.             *
     * ------------------------------------------------------------ */
-   if(outtype == 3) {
-      year_headhtml(this_year);
-      year_datahtml(this_year, tsnow);
+   for(type = 0; type < T_COUNT; type++) {
+      if(! (outtype & (1 << type))) continue;
+      double t0 = clock_sec();
+      if(ob_write(&out[type], outfile[type]) != 0) exit(-1);
+      ptime[type][P_WRITE] = clock_sec() - t0;
+   }
+
+   if(use_cache) {
+      double t0 = clock_sec();
+      cache_save();
+      ptime[T_COUNT][P_WRITE] = clock_sec() - t0;
    }
 
-   fprintf(html, "</tr>\n");
-   fprintf(html, "</table>\n");
    /* ------------------------------------------------------------ *
-    *  Close the html file                                         *
+    * With -T, print the phase times, one line per table and main. *
+    * pvbench parses these lines, and fails if they change.        *
     * ------------------------------------------------------------ */
-   fclose(html);
+   if(timing == 1) {
+      for(type = 0; type <= T_COUNT; type++) {
+         if(type < T_COUNT && ! (outtype & (1 << type))) continue;
+         printf("time table=%s fetch=%.6f reduce=%.6f render=%.6f write=%.6f rows=%ld\n",
+                table_name[type], ptime[type][P_FETCH], ptime[type][P_REDUCE],
+                ptime[type][P_RENDER], ptime[type][P_WRITE], prows[type]);
+      }
+      printf("time table=total wall=%.6f\n", clock_sec() - tstart);
+   }
+   report_free();
+   for(type = 0; type < T_COUNT; type++) ob_free(&out[type]);
    exit(0);
 }
@@ -0,0 +1,243 @@
+/* ------------------------------------------------------------ *
+ * file:        reduce.c                                        *
+ * purpose:     NaN-aware sums over the rows of a RRD fetch,    *
+ *              see reduce.h.                                   *
+ *                                                              *
+ * author:      10/18/2026 agent                                *
+ *                                                              *
+ * The vector loops take four rows per pass into two vector     *
+ * accumulators. A NaN compares unequal to itself, so x == x    *
+ * gives the mask of known values, and x AND mask turns NaN     *
+ * into 0.0. The rows left over at the end go through the plain *
+ * loop. For min/max, the accumulators start at +/-INFINITY and *
+ * a NaN row leaves them as they are: SSE2 minpd/maxpd return   *
+ * the second operand if one is NaN, NEON fminnm/fmaxnm return  *
+ * the number.                                                  *
+ * ------------------------------------------------------------ */
+#include <math.h>
+#include "reduce.h"
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+
+/* ------------------------------------------------------------ *
+ * load2() gets the values of rows k and k+1 into one vector.   *
+ * ------------------------------------------------------------ */
+static inline __m128d load2(const double *x, long k, unsigned long stride) {
+   if(stride == 1) return(_mm_loadu_pd(x + k));
+   return(_mm_set_pd(x[(k + 1) * stride], x[k * stride]));
+}
+
+static inline double hsum(__m128d v) {
+   return(_mm_cvtsd_f64(_mm_add_sd(v, _mm_unpackhi_pd(v, v))));
+}
+
+double rr_sum(const double *x, long n, unsigned long stride) {
+   __m128d acc0 = _mm_setzero_pd();
+   __m128d acc1 = _mm_setzero_pd();
+   __m128d seen = _mm_setzero_pd();
+   long k = 0;
+
+   for(; k + 4 <= n; k += 4) {
+      __m128d v0 = load2(x, k, stride);
+      __m128d v1 = load2(x, k + 2, stride);
+      __m128d m0 = _mm_cmpord_pd(v0, v0), m1 = _mm_cmpord_pd(v1, v1);
+      acc0 = _mm_add_pd(acc0, _mm_and_pd(v0, m0));
+      acc1 = _mm_add_pd(acc1, _mm_and_pd(v1, m1));
+      seen = _mm_or_pd(seen, _mm_or_pd(m0, m1));
+   }
+   double sum = hsum(_mm_add_pd(acc0, acc1));
+   int known = _mm_movemask_pd(seen);
+   for(; k < n; k++)
+      if(! isnan(x[k * stride])) { sum = sum + x[k * stride]; known = 1; }
+   return(known ? sum : NAN);
+}
+
+double rr_dot(const double *a, const double *b, long n, unsigned long stride) {
+   __m128d acc0 = _mm_setzero_pd();
+   __m128d acc1 = _mm_setzero_pd();
+   __m128d seen = _mm_setzero_pd();
+   long k = 0;
+
+   for(; k + 4 <= n; k += 4) {
+      __m128d a0 = load2(a, k, stride), b0 = load2(b, k, stride);
+      __m128d a1 = load2(a, k + 2, stride), b1 = load2(b, k + 2, stride);
+      __m128d m0 = _mm_and_pd(_mm_cmpord_pd(a0, a0), _mm_cmpord_pd(b0, b0));
+      __m128d m1 = _mm_and_pd(_mm_cmpord_pd(a1, a1), _mm_cmpord_pd(b1, b1));
+      acc0 = _mm_add_pd(acc0, _mm_and_pd(_mm_mul_pd(a0, b0), m0));
+      acc1 = _mm_add_pd(acc1, _mm_and_pd(_mm_mul_pd(a1, b1), m1));
+      seen = _mm_or_pd(seen, _mm_or_pd(m0, m1));
+   }
+   double sum = hsum(_mm_add_pd(acc0, acc1));
+   int known = _mm_movemask_pd(seen);
+   for(; k < n; k++)
+      if(! isnan(a[k * stride]) && ! isnan(b[k * stride])) {
+         sum = sum + a[k * stride] * b[k * stride];
+         known = 1;
+      }
+   return(known ? sum : NAN);
+}
+
+double rr_min(const double *x, long n, unsigned long stride) {
+   __m128d acc0 = _mm_set1_pd(INFINITY);
+   __m128d acc1 = _mm_set1_pd(INFINITY);
+   long k = 0;
+
+   for(; k + 4 <= n; k += 4) {
+      acc0 = _mm_min_pd(load2(x, k, stride), acc0);
+      acc1 = _mm_min_pd(load2(x, k + 2, stride), acc1);
+   }
+   acc0 = _mm_min_pd(acc0, acc1);
+   double m = _mm_cvtsd_f64(_mm_min_sd(acc0, _mm_unpackhi_pd(acc0, acc0)));
+   for(; k < n; k++)
+      if(x[k * stride] < m) m = x[k * stride];
+   return(isinf(m) ? NAN : m);
+}
+
+double rr_max(const double *x, long n, unsigned long stride) {
+   __m128d acc0 = _mm_set1_pd(-INFINITY);
+   __m128d acc1 = _mm_set1_pd(-INFINITY);
+   long k = 0;
+
+   for(; k + 4 <= n; k += 4) {
+      acc0 = _mm_max_pd(load2(x, k, stride), acc0);
+      acc1 = _mm_max_pd(load2(x, k + 2, stride), acc1);
+   }
+   acc0 = _mm_max_pd(acc0, acc1);
+   double m = _mm_cvtsd_f64(_mm_max_sd(acc0, _mm_unpackhi_pd(acc0, acc0)));
+   for(; k < n; k++)
+      if(x[k * stride] > m) m = x[k * stride];
+   return(isinf(m) ? NAN : m);
+}
+
+#elif defined(__aarch64__) && defined(__ARM_NEON)
+#include <arm_neon.h>
+
+/* ------------------------------------------------------------ *
+ * load2() gets the values of rows k and k+1 into one vector.   *
+ * ------------------------------------------------------------ */
+static inline float64x2_t load2(const double *x, long k, unsigned long stride) {
+   if(stride == 1) return(vld1q_f64(x + k));
+   return(vsetq_lane_f64(x[(k + 1) * stride], vdupq_n_f64(x[k * stride]), 1));
+}
+
+static inline float64x2_t known(float64x2_t v, uint64x2_t mask) {
+   return(vreinterpretq_f64_u64(vandq_u64(vreinterpretq_u64_f64(v), mask)));
+}
+
+double rr_sum(const double *x, long n, unsigned long stride) {
+   float64x2_t acc0 = vdupq_n_f64(0.0);
+   float64x2_t acc1 = vdupq_n_f64(0.0);
+   uint64x2_t seen = vdupq_n_u64(0);
+   long k = 0;
+
+   for(; k + 4 <= n; k += 4) {
+      float64x2_t v0 = load2(x, k, stride);
+      float64x2_t v1 = load2(x, k + 2, stride);
+      uint64x2_t m0 = vceqq_f64(v0, v0), m1 = vceqq_f64(v1, v1);
+      acc0 = vaddq_f64(acc0, known(v0, m0));
+      acc1 = vaddq_f64(acc1, known(v1, m1));
+      seen = vorrq_u64(seen, vorrq_u64(m0, m1));
+   }
+   double sum = vaddvq_f64(vaddq_f64(acc0, acc1));
+   int any = (vmaxvq_u32(vreinterpretq_u32_u64(seen)) != 0);
+   for(; k < n; k++)
+      if(! isnan(x[k * stride])) { sum = sum + x[k * stride]; any = 1; }
+   return(any ? sum : NAN);
+}
+
+double rr_dot(const double *a, const double *b, long n, unsigned long stride) {
+   float64x2_t acc0 = vdupq_n_f64(0.0);
+   float64x2_t acc1 = vdupq_n_f64(0.0);
+   uint64x2_t seen = vdupq_n_u64(0);
+   long k = 0;
+
+   for(; k + 4 <= n; k += 4) {
+      float64x2_t a0 = load2(a, k, stride), b0 = load2(b, k, stride);
+      float64x2_t a1 = load2(a, k + 2, stride), b1 = load2(b, k + 2, stride);
+      uint64x2_t m0 = vandq_u64(vceqq_f64(a0, a0), vceqq_f64(b0, b0));
+      uint64x2_t m1 = vandq_u64(vceqq_f64(a1, a1), vceqq_f64(b1, b1));
+      acc0 = vaddq_f64(acc0, known(vmulq_f64(a0, b0), m0));
+      acc1 = vaddq_f64(acc1, known(vmulq_f64(a1, b1), m1));
+      seen = vorrq_u64(seen, vorrq_u64(m0, m1));
+   }
+   double sum = vaddvq_f64(vaddq_f64(acc0, acc1));
+   int any = (vmaxvq_u32(vreinterpretq_u32_u64(seen)) != 0);
+   for(; k < n; k++)
+      if(! isnan(a[k * stride]) && ! isnan(b[k * stride])) {
+         sum = sum + a[k * stride] * b[k * stride];
+         any = 1;
+      }
+   return(any ? sum : NAN);
+}
+
+double rr_min(const double *x, long n, unsigned long stride) {
+   float64x2_t acc0 = vdupq_n_f64(INFINITY);
+   float64x2_t acc1 = vdupq_n_f64(INFINITY);
+   long k = 0;
+
+   for(; k + 4 <= n; k += 4) {
+      acc0 = vminnmq_f64(acc0, load2(x, k, stride));
+      acc1 = vminnmq_f64(acc1, load2(x, k + 2, stride));
+   }
+   double m = vminnmvq_f64(vminnmq_f64(acc0, acc1));
+   for(; k < n; k++)
+      if(x[k * stride] < m) m = x[k * stride];
+   return(isinf(m) ? NAN : m);
+}
+
+double rr_max(const double *x, long n, unsigned long stride) {
+   float64x2_t acc0 = vdupq_n_f64(-INFINITY);
+   float64x2_t acc1 = vdupq_n_f64(-INFINITY);
+   long k = 0;
+
+   for(; k + 4 <= n; k += 4) {
+      acc0 = vmaxnmq_f64(acc0, load2(x, k, stride));
+      acc1 = vmaxnmq_f64(acc1, load2(x, k + 2, stride));
+   }
+   double m = vmaxnmvq_f64(vmaxnmq_f64(acc0, acc1));
+   for(; k < n; k++)
+      if(x[k * stride] > m) m = x[k * stride];
+   return(isinf(m) ? NAN : m);
+}
+
+#else
+
+double rr_sum(const double *x, long n, unsigned long stride) {
+   double sum = 0.0;
+   int known = 0;
+   long k;
+   for(k = 0; k < n; k++)
+      if(! isnan(x[k * stride])) { sum = sum + x[k * stride]; known = 1; }
+   return(known ? sum : NAN);
+}
+
+double rr_dot(const double *a, const double *b, long n, unsigned long stride) {
+   double sum = 0.0;
+   int known = 0;
+   long k;
+   for(k = 0; k < n; k++)
+      if(! isnan(a[k * stride]) && ! isnan(b[k * stride])) {
+         sum = sum + a[k * stride] * b[k * stride];
+         known = 1;
+      }
+   return(known ? sum : NAN);
+}
+
+double rr_min(const double *x, long n, unsigned long stride) {
+   double m = INFINITY;
+   long k;
+   for(k = 0; k < n; k++)
+      if(x[k * stride] < m) m = x[k * stride];
+   return(isinf(m) ? NAN : m);
+}
+
+double rr_max(const double *x, long n, unsigned long stride) {
+   double m = -INFINITY;
+   long k;
+   for(k = 0; k < n; k++)
+      if(x[k * stride] > m) m = x[k * stride];
+   return(isinf(m) ? NAN : m);
+}
+
+#endif
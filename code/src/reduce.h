@@ -0,0 +1,37 @@
+/* ------------------------------------------------------------ *
+ * file:        reduce.h                                        *
+ * purpose:     NaN-aware sums over the rows of a RRD fetch.    *
+ *                                                              *
+ * author:      10/18/2026 agent                                *
+ *                                                              *
+ * rrd_fetch_r() returns the values row by row, one column per  *
+ * DS, so a DS column is a strided array with stride = ds_cnt.  *
+ * Unknown values are NaN and are left out of the sums. The     *
+ * kernels use SSE2 on x86, NEON on 64-bit ARM, and plain C     *
+ * elsewhere, e.g. on the 32-bit Raspberry Pi OS where NEON has *
+ * no double vectors. The vector code adds in a different order *
+ * so results may differ from the plain loop in the last bits.  *
+ * ------------------------------------------------------------ */
+#ifndef REDUCE_H
+#define REDUCE_H
+
+/* ------------------------------------------------------------ *
+ * rr_sum() returns the sum of x[0], x[stride], ... x[(n-1)*    *
+ * stride], skipping NaN values. rr_dot() returns the sum of    *
+ * the products a[k*stride] * b[k*stride] for the rows where    *
+ * both values are known. Both return NAN if no row is known,   *
+ * so that a range without data is not taken as 0. rrd_value_t  *
+ * is a double.                                                 *
+ * ------------------------------------------------------------ */
+double rr_sum(const double *x, long n, unsigned long stride);
+double rr_dot(const double *a, const double *b, long n, unsigned long stride);
+
+/* ------------------------------------------------------------ *
+ * rr_min() and rr_max() return the smallest and largest known  *
+ * value of x[0], x[stride], ... x[(n-1)*stride], or NAN if all *
+ * values are unknown.                                          *
+ * ------------------------------------------------------------ */
+double rr_min(const double *x, long n, unsigned long stride);
+double rr_max(const double *x, long n, unsigned long stride);
+
+#endif
@@ -4,7 +4,7 @@
 #
 # This script runs in 1-min intervals through cron.
 # It has the following 2 tasks:
-# 	1. Read the serial data   -> web/getsolar.htm
+# 	1. Read the serial data   -> web/getsolar.htm, rrd/samples.*
 #	2. Update RRD database    -> rrd/solar.rrd
 #	3. Internet server upload -> weather.fm4dd.com
 #
@@ -82,7 +82,21 @@ fi
 # webpage display and Internet server upload. 
 ##########################################################
 echo "solar-data.sh: Getting serial data from $SDEV";
-EXECUTE="$VHOME/bin/getvictron -s $SDEV -o $WEBHOME/getsolar.htm"
+SSTORE=$VHOME/rrd/${MYCONFIG[pi-solar-sst]}
+ESTATE=$VHOME/rrd/${MYCONFIG[pi-solar-est]}
+
+# Without energy state (first run, lost file), continue the
+# counters from their last RRD values instead of 0.
+if [[ ! -s $ESTATE ]]; then
+   SEED=`$RRDTOOL lastupdate $RRD 2>/dev/null | awk '
+      NR == 1       { for(i = 1; i <= NF; i++) col[$i] = i + 1 }
+      /^[0-9]+:/    { if("eload" in col) print $col["epv"], $col["echg"], $col["edis"], $col["eload"] }'`
+   if [[ -n "$SEED" && "$SEED" != *U* ]]; then
+      echo "solar-data.sh: Seeding energy state $ESTATE from RRD: $SEED"
+      echo "0 0 0 0 0 $SEED" > $ESTATE
+   fi
+fi
+EXECUTE="$VHOME/bin/getvictron -s $SDEV -o $WEBHOME/getsolar.htm -a $SSTORE -e $ESTATE"
 echo "solar-data.sh: $EXECUTE";
 RRDUPDATE=`$EXECUTE`
 RET=$?
@@ -125,10 +139,23 @@ fi
 ##########################################################
 # 3. Update the RRD database. Add the daytcalc flag to the
 # getvictron RRD update string before calling rrdupdate.
-##########################################################
+# The energy and yield counters come before the daytime
+# flag, the template maps the values to the DS names.
+# A database without the counter DS (not yet upgraded with
+# install/rrdupgrade.sh) only gets the original values.
+##########################################################
+RRDBASE=`echo $RRDUPDATE | cut -d ":" -f 1-7`
+if $RRDTOOL info $RRD | grep -q "^ds\[ylds\]"; then
+   RRDTMPL="vbat:ibat:vpnl:ppnl:load:opcs:epv:echg:edis:eload:yldt:yldd:ylds:dayt"
+   RRDVALS="$RRDUPDATE:$DAYT"
+else
+   echo "solar-data.sh: $RRD has no energy counter DS, run install/rrdupgrade.sh"
+   RRDTMPL="vbat:ibat:vpnl:ppnl:load:opcs:dayt"
+   RRDVALS="$RRDBASE:$DAYT"
+fi
 echo "solar-data.sh: Updating RRD database $RRD"
-echo "$RRDTOOL update $RRD $RRDUPDATE:$DAYT"
-$RRDTOOL updatev $RRD "$RRDUPDATE:$DAYT"
+echo "$RRDTOOL update $RRD --template $RRDTMPL $RRDVALS"
+$RRDTOOL updatev $RRD --template $RRDTMPL "$RRDVALS"
 
 ##########################################################
 # 4. Update RRD graphs in a separate process and continue
@@ -138,7 +165,9 @@ $RRDGRAPH &
 
 ##########################################################
 # 5. Create solar.txt, send it together with getsolar.htm
-# to the Internet server
+# to the Internet server. solar.txt keeps the original
+# format ts:vbat:ibat:vpnl:ppnl:load:opcs:dayt, without
+# the energy counters.
 ##########################################################
 echo "solar-data.sh: Data upload"
 if [ ${MYCONFIG[pi-solar-sftp]} == "none" ]; then
@@ -146,8 +175,8 @@ if [ ${MYCONFIG[pi-solar-sftp]} == "none" ]; then
    exit
 fi
 
-echo "solar-data.sh: echo \"$RRDUPDATE:$DAYT\" > $VHOME/var/solar.txt"
-echo "$RRDUPDATE:$DAYT" > $LOGHOME/solar.txt
+echo "solar-data.sh: echo \"$RRDBASE:$DAYT\" > $VHOME/var/solar.txt"
+echo "$RRDBASE:$DAYT" > $LOGHOME/solar.txt
 
 SFTPDEST=$STATION@${MYCONFIG[pi-solar-sftp]}
 
@@ -45,6 +45,7 @@ readconfig MYCONFIG < "$CONFIG"
 PVPOWER="${MYCONFIG[pi-solar-dir]}/bin/pvpower"
 
 RRD=${MYCONFIG[pi-solar-dir]}/rrd/${MYCONFIG[pi-solar-rrd]}
+DTCACHE=${MYCONFIG[pi-solar-dir]}/rrd/${MYCONFIG[pi-solar-dtc]}
 RRDTOOL="/usr/bin/rrdtool"
 
 ##########################################################
@@ -464,11 +465,23 @@ DAYHTMFILE=$WEBPATH/daypower.htm
 if [ -f $DAYHTMFILE ]; then FILEAGE=$(date -r $DAYHTMFILE +%s); fi
 if [ ! -f $DAYHTMFILE ] || [[ "$FILEAGE" < "$midnight" ]]; then
   echo -n "Creating $DAYHTMFILE... "
-  $PVPOWER -s $RRD -d $DAYHTMFILE
+  $PVPOWER -s $RRD -c $DTCACHE -d $DAYHTMFILE
   cp $DAYHTMFILE $VARPATH/daypower.htm
   echo " Done."
 fi
 
+##########################################################
+# Daily update of the 12-days min/max voltage htm file
+##########################################################
+DAYMMXFILE=$WEBPATH/daymimax.htm
+
+if [ -f $DAYMMXFILE ]; then FILEAGE=$(date -r $DAYMMXFILE +%s); fi
+if [ ! -f $DAYMMXFILE ] || [[ "$FILEAGE" < "$midnight" ]]; then
+  echo -n "Creating $DAYMMXFILE... "
+  $PVPOWER -s $RRD -r minmax -d $DAYMMXFILE
+  echo " Done."
+fi
+
 echo "solar-rrd.sh: Finished `date`"
 ###########################################################
 ## Daily update of the monthly Min/Max Temperature htm file
@@ -478,7 +491,7 @@ echo "solar-rrd.sh: Finished `date`"
 #if [ -f $MONHTMFILE ]; then FILEAGE=$(date -r $MONHTMFILE +%s); fi
 #if [ ! -f $MONHTMFILE ] || [[ "$FILEAGE" < "$midnight" ]]; then
 #  echo -n "Creating $MONHTMFILE... "
-#  $PVPOWER -s $RRD -m $MONHTMFILE
+#  $PVPOWER -s $RRD -c $DTCACHE -m $MONHTMFILE
 #  cp $MONHTMFILE $VARPATH/monpower.htm
 #  echo " Done."
 #fi
@@ -115,11 +115,67 @@
 //         Limited azimuth180 to range of 0 to 360 deg (instead of -180 to 180) for tech report consistency
 //         Changed all variables names from azimuth180 to azimuth_astro
 //         Renamed 2 "utility" function names for consistency
+// Revised 18-OCT-2026 agent
+//         Added spa_calculate_batch() for arrays of Unix timestamps at one location.
+//         Vectorized earth_periodic_term_summation() with SSE2/AVX or NEON (aarch64).
+//         Added a per-thread cache of the sun rise/transit/set results, calls within one
+//         day at one location only calculate the instantaneous sun position.
+//         Added the function codes SPA_FAST_ZA and SPA_FAST_ZA_INC for an approximate,
+//         faster sun position, see the header file for its accuracy.
 ///////////////////////////////////////////////////////////////////////////////////////////////
 
 #include <math.h>
+#include <string.h>
 #include "spa.h"
 
+///////////////////////////////////////////////////////////////////////////////////////////////
+// SIMD vector operations for earth_periodic_term_summation(), SPA_SIMD is the number of
+// doubles per vector. x86-64 always has SSE2, AVX needs -mavx (or -march=native). On the
+// Pi, NEON has double vectors on aarch64 (64-bit OS) only, 32-bit ARM uses the scalar code.
+// Build with -DSPA_NO_SIMD to use the scalar code everywhere, e.g. to compare the results.
+///////////////////////////////////////////////////////////////////////////////////////////////
+#if !defined(SPA_NO_SIMD) && defined(__AVX__)
+#include <immintrin.h>
+#define SPA_SIMD 4
+typedef __m256d vdbl;
+typedef __m256d vmask;
+#define v_set1(x)       _mm256_set1_pd(x)
+#define v_add(a,b)      _mm256_add_pd(a,b)
+#define v_sub(a,b)      _mm256_sub_pd(a,b)
+#define v_mul(a,b)      _mm256_mul_pd(a,b)
+#define v_round(a)      _mm256_round_pd(a, _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC)
+#define v_cmpeq(a,b)    _mm256_cmp_pd(a,b,_CMP_EQ_OQ)
+#define v_cmplt(a,b)    _mm256_cmp_pd(a,b,_CMP_LT_OQ)
+#define v_select(m,a,b) _mm256_blendv_pd(b,a,m)
+#elif !defined(SPA_NO_SIMD) && defined(__SSE2__)
+#include <emmintrin.h>
+#define SPA_SIMD 2
+typedef __m128d vdbl;
+typedef __m128d vmask;
+#define v_set1(x)       _mm_set1_pd(x)
+#define v_add(a,b)      _mm_add_pd(a,b)
+#define v_sub(a,b)      _mm_sub_pd(a,b)
+#define v_mul(a,b)      _mm_mul_pd(a,b)
+#define v_round(a)      _mm_sub_pd(_mm_add_pd(a, _mm_set1_pd(6755399441055744.0)), \
+                                                 _mm_set1_pd(6755399441055744.0))
+#define v_cmpeq(a,b)    _mm_cmpeq_pd(a,b)
+#define v_cmplt(a,b)    _mm_cmplt_pd(a,b)
+#define v_select(m,a,b) _mm_or_pd(_mm_and_pd(m,a), _mm_andnot_pd(m,b))
+#elif !defined(SPA_NO_SIMD) && defined(__ARM_NEON) && defined(__aarch64__)
+#include <arm_neon.h>
+#define SPA_SIMD 2
+typedef float64x2_t vdbl;
+typedef uint64x2_t  vmask;
+#define v_set1(x)       vdupq_n_f64(x)
+#define v_add(a,b)      vaddq_f64(a,b)
+#define v_sub(a,b)      vsubq_f64(a,b)
+#define v_mul(a,b)      vmulq_f64(a,b)
+#define v_round(a)      vrndnq_f64(a)
+#define v_cmpeq(a,b)    vceqq_f64(a,b)
+#define v_cmplt(a,b)    vcltq_f64(a,b)
+#define v_select(m,a,b) vbslq_f64(m,a,b)
+#endif
+
 #define PI         3.1415926535897932384626433832795028841971
 #define SUN_RADIUS 0.26667
 
@@ -620,7 +676,8 @@ int validate_inputs(spa_data *spa)
     if (fabs(spa->atmos_refract) > 5       ) return 16;
     if (     spa->elevation      < -6500000) return 11;
 
-    if ((spa->function == SPA_ZA_INC) || (spa->function == SPA_ALL))
+    if ((spa->function == SPA_ZA_INC) || (spa->function == SPA_ALL) ||
+        (spa->function == SPA_FAST_ZA_INC))
     {
         if (fabs(spa->slope)         > 360) return 14;
         if (fabs(spa->azm_rotation)  > 360) return 15;
@@ -670,13 +727,120 @@ double julian_ephemeris_millennium(double jce)
     return (jce/10.0);
 }
 
+#ifdef SPA_SIMD
+///////////////////////////////////////////////////////////////////////////////////////////////
+// Load the A, B and C values of SPA_SIMD term rows into one vector each
+///////////////////////////////////////////////////////////////////////////////////////////////
+#if SPA_SIMD == 2 && defined(__aarch64__)
+static inline void v_load_terms(const double *row, vdbl *a, vdbl *b, vdbl *c)
+{
+    float64x2x3_t t = vld3q_f64(row);
+
+    *a = t.val[TERM_A];
+    *b = t.val[TERM_B];
+    *c = t.val[TERM_C];
+}
+#else
+static inline void v_load_terms2(const double *row, __m128d *a, __m128d *b, __m128d *c)
+{
+    __m128d p0 = _mm_loadu_pd(row);         // A0 B0
+    __m128d p1 = _mm_loadu_pd(row + 2);     // C0 A1
+    __m128d p2 = _mm_loadu_pd(row + 4);     // B1 C1
+
+    *a = _mm_shuffle_pd(p0, p1, 2);
+    *b = _mm_shuffle_pd(p0, p2, 1);
+    *c = _mm_shuffle_pd(p1, p2, 2);
+}
+
+static inline void v_load_terms(const double *row, vdbl *a, vdbl *b, vdbl *c)
+{
+#if SPA_SIMD == 4
+    __m128d a0, b0, c0, a1, b1, c1;
+
+    v_load_terms2(row,                  &a0, &b0, &c0);
+    v_load_terms2(row + 2*TERM_COUNT,   &a1, &b1, &c1);
+    *a = _mm256_insertf128_pd(_mm256_castpd128_pd256(a0), a1, 1);
+    *b = _mm256_insertf128_pd(_mm256_castpd128_pd256(b0), b1, 1);
+    *c = _mm256_insertf128_pd(_mm256_castpd128_pd256(c0), c1, 1);
+#else
+    v_load_terms2(row, a, b, c);
+#endif
+}
+#endif
+
+static inline double v_sum(vdbl v)
+{
+#if SPA_SIMD == 4
+    __m128d s = _mm_add_pd(_mm256_castpd256_pd128(v), _mm256_extractf128_pd(v, 1));
+    return _mm_cvtsd_f64(_mm_add_sd(s, _mm_unpackhi_pd(s, s)));
+#elif defined(__aarch64__)
+    return vaddvq_f64(v);
+#else
+    return _mm_cvtsd_f64(_mm_add_sd(v, _mm_unpackhi_pd(v, v)));
+#endif
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////////
+// Cosine of each element of x. The argument is reduced by k*PI/2 in three parts (fdlibm),
+// exact for |x| < 1.6e6, the term arguments B+C*jme stay below 2e5. The sine and cosine
+// polynomials on [-PI/4, PI/4] are those of Cephes, the result is within 2 ulp of cos().
+///////////////////////////////////////////////////////////////////////////////////////////////
+static inline vdbl v_cos(vdbl x)
+{
+    vdbl k  = v_round(v_mul(x, v_set1(2.0/PI)));
+    vdbl r  = v_sub(v_sub(v_sub(x, v_mul(k, v_set1(1.57079632673412561417e+00))),
+                                   v_mul(k, v_set1(6.07710050630396597660e-11))),
+                                   v_mul(k, v_set1(2.02226624879595063154e-21)));
+    vdbl z  = v_mul(r, r);
+    vdbl ps = v_set1(1.58962301576546568060e-10);
+    vdbl pc = v_set1(-1.13585365213876817300e-11);
+    vdbl q, odd, sn, cs, y;
+
+    ps = v_add(v_mul(ps, z), v_set1(-2.50507477628578072866e-8));
+    ps = v_add(v_mul(ps, z), v_set1( 2.75573136213857245213e-6));
+    ps = v_add(v_mul(ps, z), v_set1(-1.98412698295895385996e-4));
+    ps = v_add(v_mul(ps, z), v_set1( 8.33333333332211858878e-3));
+    ps = v_add(v_mul(ps, z), v_set1(-1.66666666666666307295e-1));
+    sn = v_add(r, v_mul(v_mul(r, z), ps));
+
+    pc = v_add(v_mul(pc, z), v_set1( 2.08757008419747316778e-9));
+    pc = v_add(v_mul(pc, z), v_set1(-2.75573141792967388112e-7));
+    pc = v_add(v_mul(pc, z), v_set1( 2.48015872888517045348e-5));
+    pc = v_add(v_mul(pc, z), v_set1(-1.38888888888730564116e-3));
+    pc = v_add(v_mul(pc, z), v_set1( 4.16666666666665929218e-2));
+    cs = v_add(v_sub(v_set1(1.0), v_mul(z, v_set1(0.5))), v_mul(v_mul(z, z), pc));
+
+    // quadrant q = k mod 4: cos r, -sin r, -cos r, sin r
+    q   = v_sub(k, v_mul(v_set1(4.0), v_round(v_mul(v_sub(k, v_set1(1.5)), v_set1(0.25)))));
+    odd = v_sub(q, v_mul(v_set1(2.0), v_round(v_mul(v_sub(q, v_set1(0.5)), v_set1(0.5)))));
+    y   = v_select(v_cmpeq(odd, v_set1(1.0)), sn, cs);
+    z   = v_sub(q, v_set1(1.5));
+    return v_select(v_cmplt(v_mul(z, z), v_set1(1.0)), v_sub(v_set1(0.0), y), y);
+}
+#endif
+
 double earth_periodic_term_summation(const double terms[][TERM_COUNT], int count, double jme)
 {
-    int i;
+    int i = 0;
     double sum=0;
 
-    for (i = 0; i < count; i++)
+#ifdef SPA_SIMD
+    double pad[SPA_SIMD][TERM_COUNT] = {{0}};    // the last rows, A=0 rows add nothing
+    vdbl a, b, c, vsum = v_set1(0.0), vjme = v_set1(jme);
+
+    for (; i < count; i += SPA_SIMD) {
+        if (i + SPA_SIMD <= count) v_load_terms(terms[i], &a, &b, &c);
+        else {
+            memcpy(pad, terms[i], (count - i)*sizeof(pad[0]));
+            v_load_terms(pad[0], &a, &b, &c);
+        }
+        vsum = v_add(vsum, v_mul(a, v_cos(v_add(b, v_mul(c, vjme)))));
+    }
+    sum = v_sum(vsum);
+#else
+    for (; i < count; i++)
         sum += terms[i][TERM_A]*cos(terms[i][TERM_B]+terms[i][TERM_C]*jme);
+#endif
 
     return sum;
 }
@@ -1050,6 +1214,117 @@ void calculate_geocentric_sun_right_ascension_and_declination(spa_data *spa)
     spa->delta = geocentric_declination(spa->beta, spa->epsilon, spa->lamda);
 }
 
+///////////////////////////////////////////////////////////////////////////////////////////
+// Calculate an approximate geocentric sun position for SPA_FAST_ZA and SPA_FAST_ZA_INC
+// Low accuracy solar coordinates from J. Meeus, "Astronomical Algorithms", chapter 25,
+// which the NOAA solar calculator uses. The sun's longitude comes from a 3 term equation
+// of center instead of the VSOP87 periodic terms, nutation from the moon's ascending node
+// only. The maximum error against SPA is listed in the header file.
+///////////////////////////////////////////////////////////////////////////////////////////
+void calculate_fast_geocentric_sun_right_ascension_and_declination(spa_data *spa)
+{
+    double t, l0, m_rad, c, e, omega_rad;
+
+    spa->jc  = julian_century(spa->jd);
+    spa->jde = julian_ephemeris_day(spa->jd, spa->delta_t);
+    spa->jce = julian_ephemeris_century(spa->jde);
+    spa->jme = julian_ephemeris_millennium(spa->jce);
+    t        = spa->jce;
+
+    l0        = 280.46646 + t*(36000.76983 + t*0.0003032);
+    m_rad     = deg2rad(357.52911 + t*(35999.05029 - t*0.0001537));
+    c         = (1.914602 - t*(0.004817 + t*0.000014))*sin(m_rad) +
+                (0.019993 - t*0.000101)*sin(2*m_rad) + 0.000289*sin(3*m_rad);
+    e         = 0.016708634 - t*(0.000042037 + t*0.0000001267);
+    omega_rad = deg2rad(125.04 - 1934.136*t);
+
+    spa->r        = 1.000001018*(1 - e*e) / (1 + e*cos(m_rad + deg2rad(c)));
+    spa->theta    = limit_degrees(l0 + c);
+    spa->beta     = 0;
+    spa->l        = limit_degrees(spa->theta + 180);
+    spa->b        = 0;
+
+    //the nutation arguments are not needed here, they are set for the callers
+    spa->x0 = mean_elongation_moon_sun(t);
+    spa->x1 = mean_anomaly_sun(t);
+    spa->x2 = mean_anomaly_moon(t);
+    spa->x3 = argument_latitude_moon(t);
+    spa->x4 = ascending_longitude_moon(t);
+
+    spa->del_psi     = -0.00478*sin(omega_rad);
+    spa->del_epsilon = 0.00256*cos(omega_rad);
+    spa->epsilon0    = 84381.448 - t*(46.8150 + t*(0.00059 - t*0.001813));
+    spa->epsilon     = ecliptic_true_obliquity(spa->del_epsilon, spa->epsilon0);
+
+    spa->del_tau  = -0.00569;
+    spa->lamda    = apparent_sun_longitude(spa->theta, spa->del_psi, spa->del_tau);
+
+    spa->nu0      = greenwich_mean_sidereal_time (spa->jd, spa->jc);
+    spa->nu       = greenwich_sidereal_time (spa->nu0, spa->del_psi, spa->epsilon);
+
+    spa->alpha = geocentric_right_ascension(spa->lamda, spa->epsilon, spa->beta);
+    spa->delta = geocentric_declination(spa->beta, spa->epsilon, spa->lamda);
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////
+// Cache of the sun rise/transit/set results. They depend on the (local) date, location,
+// timezone, delta_t and refraction setting, not on the time of day, so the calls within a
+// day reuse them instead of four geocentric sun position calculations. The cache is per
+// thread, entries are replaced in turn.
+///////////////////////////////////////////////////////////////////////////////////////////
+#define RTS_CACHE_COUNT 4
+
+typedef struct
+{
+    int    valid;
+    int    year, month, day;
+    double latitude, longitude, timezone, delta_t, atmos_refract;
+    double srha, ssha, sta, suntransit, sunrise, sunset;
+} rts_cache_entry;
+
+static _Thread_local rts_cache_entry rts_cache[RTS_CACHE_COUNT];
+static _Thread_local int rts_cache_next;
+
+static rts_cache_entry *rts_cache_find(const spa_data *spa)
+{
+    int i;
+
+    for (i = 0; i < RTS_CACHE_COUNT; i++) {
+        rts_cache_entry *c = &rts_cache[i];
+
+        if (c->valid && c->year == spa->year && c->month == spa->month && c->day == spa->day &&
+            c->latitude == spa->latitude && c->longitude == spa->longitude &&
+            c->timezone == spa->timezone && c->delta_t == spa->delta_t &&
+            c->atmos_refract == spa->atmos_refract)
+            return c;
+    }
+
+    return NULL;
+}
+
+static void rts_cache_store(const spa_data *spa)
+{
+    rts_cache_entry *c = &rts_cache[rts_cache_next];
+
+    rts_cache_next = (rts_cache_next + 1) % RTS_CACHE_COUNT;
+
+    c->valid         = 1;
+    c->year          = spa->year;
+    c->month         = spa->month;
+    c->day           = spa->day;
+    c->latitude      = spa->latitude;
+    c->longitude     = spa->longitude;
+    c->timezone      = spa->timezone;
+    c->delta_t       = spa->delta_t;
+    c->atmos_refract = spa->atmos_refract;
+    c->srha          = spa->srha;
+    c->ssha          = spa->ssha;
+    c->sta           = spa->sta;
+    c->suntransit    = spa->suntransit;
+    c->sunrise       = spa->sunrise;
+    c->sunset        = spa->sunset;
+}
+
 ////////////////////////////////////////////////////////////////////////
 // Calculate Equation of Time (EOT) and Sun Rise, Transit, & Set (RTS)
 ////////////////////////////////////////////////////////////////////////
@@ -1062,12 +1337,24 @@ void calculate_eot_and_sun_rise_transit_set(spa_data *spa)
     double m_rts[SUN_COUNT], nu_rts[SUN_COUNT], h_rts[SUN_COUNT];
     double alpha_prime[SUN_COUNT], delta_prime[SUN_COUNT], h_prime[SUN_COUNT];
     double h0_prime = -1*(SUN_RADIUS + spa->atmos_refract);
+    rts_cache_entry *c;
     int i;
 
 	sun_rts  = *spa;
     m        = sun_mean_longitude(spa->jme);
     spa->eot = eot(m, spa->alpha, spa->del_psi, spa->epsilon);
 
+    c = rts_cache_find(spa);
+    if (c != NULL) {
+        spa->srha       = c->srha;
+        spa->ssha       = c->ssha;
+        spa->sta        = c->sta;
+        spa->suntransit = c->suntransit;
+        spa->sunrise    = c->sunrise;
+        spa->sunset     = c->sunset;
+        return;
+    }
+
     sun_rts.hour = sun_rts.minute = sun_rts.second = 0;
 	sun_rts.delta_ut1 = sun_rts.timezone = 0.0;
 
@@ -1121,6 +1408,7 @@ void calculate_eot_and_sun_rise_transit_set(spa_data *spa)
 
     } else spa->srha= spa->ssha= spa->sta= spa->suntransit= spa->sunrise= spa->sunset= -99999;
 
+    rts_cache_store(spa);
 }
 
 ///////////////////////////////////////////////////////////////////////////////////////////
@@ -1138,7 +1426,10 @@ int spa_calculate(spa_data *spa)
         spa->jd = julian_day (spa->year,   spa->month,  spa->day,       spa->hour,
 			                  spa->minute, spa->second, spa->delta_ut1, spa->timezone);
 
-        calculate_geocentric_sun_right_ascension_and_declination(spa);
+        if ((spa->function == SPA_FAST_ZA) || (spa->function == SPA_FAST_ZA_INC))
+            calculate_fast_geocentric_sun_right_ascension_and_declination(spa);
+        else
+            calculate_geocentric_sun_right_ascension_and_declination(spa);
 
         spa->h  = observer_hour_angle(spa->nu, spa->longitude, spa->alpha);
         spa->xi = sun_equatorial_horizontal_parallax(spa->r);
@@ -1159,7 +1450,8 @@ int spa_calculate(spa_data *spa)
                                                                            spa->delta_prime);
         spa->azimuth       = topocentric_azimuth_angle(spa->azimuth_astro);
 
-        if ((spa->function == SPA_ZA_INC) || (spa->function == SPA_ALL))
+        if ((spa->function == SPA_ZA_INC) || (spa->function == SPA_ALL) ||
+            (spa->function == SPA_FAST_ZA_INC))
             spa->incidence  = surface_incidence_angle(spa->zenith, spa->azimuth_astro,
                                                       spa->azm_rotation, spa->slope);
 
@@ -1169,4 +1461,126 @@ int spa_calculate(spa_data *spa)
 
     return result;
 }
-///////////////////////////////////////////////////////////////////////////////////////////
\ No newline at end of file
+///////////////////////////////////////////////////////////////////////////////////////////
+
+///////////////////////////////////////////////////////////////////////////////////////////
+// Observer values of a batch, they only depend on the location and are computed once
+// per spa_calculate_batch() call instead of once per timestamp
+///////////////////////////////////////////////////////////////////////////////////////////
+typedef struct
+{
+    double sin_lat, cos_lat;      // observer latitude
+    double x, y;                  // parallax terms, see right_ascension_parallax_and_topocentric_dec()
+    double refract;               // pressure and temperature factor of the refraction correction
+    double e0_min;                // no refraction correction below this elevation angle
+    double sin_slope, cos_slope;  // surface slope
+} spa_site;
+
+static void batch_site(const spa_data *spa, spa_site *site)
+{
+    double lat_rad   = deg2rad(spa->latitude);
+    double slope_rad = deg2rad(spa->slope);
+    double u         = atan(0.99664719 * tan(lat_rad));
+
+    site->sin_lat   = sin(lat_rad);
+    site->cos_lat   = cos(lat_rad);
+    site->y         = 0.99664719 * sin(u) + spa->elevation*site->sin_lat/6378140.0;
+    site->x         =              cos(u) + spa->elevation*site->cos_lat/6378140.0;
+    site->refract   = (spa->pressure / 1010.0) * (283.0 / (273.0 + spa->temperature)) * 1.02;
+    site->e0_min    = -1*(SUN_RADIUS + spa->atmos_refract);
+    site->sin_slope = sin(slope_rad);
+    site->cos_slope = cos(slope_rad);
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////
+// Local calendar date of a Unix timestamp, timezone in hours (proleptic Gregorian calendar)
+///////////////////////////////////////////////////////////////////////////////////////////
+static void batch_local_date(time_t ts, double timezone, int *year, int *month, int *day)
+{
+    long days = (long)floor(((double)ts + timezone*3600.0) / 86400.0) + 719468;
+    long era  = (days >= 0 ? days : days - 146096) / 146097;
+    long doe  = days - era * 146097;
+    long yoe  = (doe - doe/1460 + doe/36524 - doe/146096) / 365;
+    long doy  = doe - (365*yoe + yoe/4 - yoe/100);
+    long mp   = (5*doy + 2) / 153;
+
+    *day   = (int)(doy - (153*mp + 2)/5 + 1);
+    *month = (int)(mp < 10 ? mp + 3 : mp - 9);
+    *year  = (int)(yoe + era * 400 + (*month <= 2));
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////
+// Calculate zenith, azimuth and incidence for count Unix timestamps, see spa.h
+// The steps are those of spa_calculate(), with the location terms taken from spa_site
+///////////////////////////////////////////////////////////////////////////////////////////
+int spa_calculate_batch(const spa_data *spa, const time_t *ts, int count, spa_batch *out)
+{
+    spa_data sun;
+    spa_site site;
+    double xi_rad, sin_xi, den, h_rad, delta_rad, delta_alpha_rad, dp_rad, hp_rad;
+    double h, h_prime, e0, e, azimuth_astro;
+    int result, i, rts, fast;
+
+    sun = *spa;                   // the date and time values are not used, keep them valid
+    sun.year = 2000;
+    sun.month = sun.day = 1;
+    sun.hour = sun.minute = 0;
+    sun.second = 0;
+
+    result = validate_inputs(&sun);
+    if (result != 0) return result;
+
+    batch_site(spa, &site);
+
+    fast = (spa->function == SPA_FAST_ZA) || (spa->function == SPA_FAST_ZA_INC);
+    rts = ((spa->function == SPA_ZA_RTS) || (spa->function == SPA_ALL)) &&
+          (out->suntransit != NULL || out->sunrise != NULL || out->sunset != NULL);
+
+    for (i = 0; i < count; i++) {
+        sun.jd = 2440587.5 + ((double)ts[i] + spa->delta_ut1)/86400.0;
+
+        if (fast) calculate_fast_geocentric_sun_right_ascension_and_declination(&sun);
+        else      calculate_geocentric_sun_right_ascension_and_declination(&sun);
+
+        xi_rad    = deg2rad(sun_equatorial_horizontal_parallax(sun.r));
+        h         = observer_hour_angle(sun.nu, spa->longitude, sun.alpha);
+        h_rad     = deg2rad(h);
+        delta_rad = deg2rad(sun.delta);
+
+        sin_xi    = sin(xi_rad);
+        den       = cos(delta_rad) - site.x*sin_xi*cos(h_rad);
+
+        delta_alpha_rad = atan2(-site.x*sin_xi*sin(h_rad), den);
+        dp_rad = atan2((sin(delta_rad) - site.y*sin_xi)*cos(delta_alpha_rad), den);
+
+        h_prime = h - rad2deg(delta_alpha_rad);
+        hp_rad  = deg2rad(h_prime);
+
+        e0 = rad2deg(asin(site.sin_lat*sin(dp_rad) + site.cos_lat*cos(dp_rad)*cos(hp_rad)));
+        e  = e0;
+        if (e0 >= site.e0_min)
+            e += site.refract / (60.0 * tan(deg2rad(e0 + 10.3/(e0 + 5.11))));
+
+        azimuth_astro = limit_degrees(rad2deg(atan2(sin(hp_rad),
+                            cos(hp_rad)*site.sin_lat - tan(dp_rad)*site.cos_lat)));
+
+        out->zenith[i]  = topocentric_zenith_angle(e);
+        out->azimuth[i] = topocentric_azimuth_angle(azimuth_astro);
+
+        if (out->incidence != NULL && ((spa->function == SPA_ZA_INC) || (spa->function == SPA_ALL) ||
+                                       (spa->function == SPA_FAST_ZA_INC)))
+            out->incidence[i] = rad2deg(acos(cos(deg2rad(out->zenith[i]))*site.cos_slope +
+                                site.sin_slope*sin(deg2rad(out->zenith[i])) *
+                                cos(deg2rad(azimuth_astro - spa->azm_rotation))));
+
+        if (rts) {                // from the cache, except for the first timestamp of a day
+            batch_local_date(ts[i], spa->timezone, &sun.year, &sun.month, &sun.day);
+            calculate_eot_and_sun_rise_transit_set(&sun);
+            if (out->suntransit != NULL) out->suntransit[i] = sun.suntransit;
+            if (out->sunrise    != NULL) out->sunrise[i]    = sun.sunrise;
+            if (out->sunset     != NULL) out->sunset[i]     = sun.sunset;
+        }
+    }
+
+    return 0;
+}
@@ -0,0 +1,658 @@
+/* ------------------------------------------------------------ *
+ * file:        sstore.c                                        *
+ * purpose:     Raw sample store for the ve.direct readings,    *
+ *              see sstore.h for the file layout. The main      *
+ *              functions are:                                  *
+ *                 ss_open() / ss_close()                       *
+ *                 ss_append()  add one sample (getvictron)     *
+ *                 ss_read()    decode a time range (queries)   *
+ *                 ss_agg_*()   aggregate samples and block     *
+ *                              summaries (solarq)              *
+ *                                                              *
+ * author:      10/18/2026 agent                                *
+ *                                                              *
+ * Column coding, one bit stream per column and block:          *
+ * timestamp: first value as raw 64 bits, then the delta of the *
+ *            delta to the previous timestamp (0 for a steady   *
+ *            1s or 60s sample rate).                           *
+ * values:    delta to the previous value, starting from 0.     *
+ * Each signed difference is zigzag-mapped to unsigned, then    *
+ * written with a unary bucket prefix:                          *
+ *   '0'                    difference is 0  (1 bit)            *
+ *   '10'   +  7 bit value  zigzag < 128     (9 bits)           *
+ *   '110'  +  9 bit value  zigzag < 512     (12 bits)          *
+ *   '1110' + 12 bit value  zigzag < 4096    (16 bits)          *
+ *   '1111' + 64 bit value  anything else    (68 bits)          *
+ * ------------------------------------------------------------ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <errno.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "sstore.h"
+
+const char *ss_colname[SS_COLS] = { "vbat", "ibat", "vpnl", "ppnl", "load", "opcs" };
+
+/* worst case encoded size of one column: 68 bits per sample */
+#define SS_COLBUF (SS_BLOCK_MAX * 9 + 16)
+
+static const int bucket_bits[5] = { 0, 7, 9, 12, 64 };
+
+/* ------------------------------------------------------------ *
+ * zigzag maps signed differences to unsigned: 0,-1,1,-2 ->0,1,2*
+ * ------------------------------------------------------------ */
+static inline uint64_t zz_enc(int64_t v) { return ((uint64_t) v << 1) ^ (uint64_t) (v >> 63); }
+static inline int64_t  zz_dec(uint64_t u) { return (int64_t) (u >> 1) ^ -(int64_t) (u & 1); }
+
+/* ------------------------------------------------------------ *
+ * Bit writer, MSB first into a byte buffer                     *
+ * ------------------------------------------------------------ */
+typedef struct { uint8_t *buf; size_t pos; uint64_t acc; int nacc; } bitw;
+
+static void bw_put(bitw *w, uint64_t v, int n) {
+   if(n > 32) { bw_put(w, v >> 32, n - 32); v &= 0xffffffffULL; n = 32; }
+   if(n == 0) return;
+   w->acc = (w->acc << n) | (v & ((1ULL << n) - 1));
+   w->nacc += n;
+   while(w->nacc >= 8) {
+      w->nacc -= 8;
+      w->buf[w->pos++] = (uint8_t) (w->acc >> w->nacc);
+   }
+}
+
+static size_t bw_flush(bitw *w) {
+   if(w->nacc > 0) w->buf[w->pos++] = (uint8_t) (w->acc << (8 - w->nacc));
+   w->nacc = 0;
+   return w->pos;
+}
+
+static void bw_bucket(bitw *w, int64_t diff) {
+   uint64_t u = zz_enc(diff);
+   if(u == 0)         bw_put(w, 0x0, 1);
+   else if(u < 128)   { bw_put(w, 0x2, 2); bw_put(w, u, 7);  }
+   else if(u < 512)   { bw_put(w, 0x6, 3); bw_put(w, u, 9);  }
+   else if(u < 4096)  { bw_put(w, 0xe, 4); bw_put(w, u, 12); }
+   else               { bw_put(w, 0xf, 4); bw_put(w, u, 64); }
+}
+
+/* ------------------------------------------------------------ *
+ * Bit reader: acc holds the next bits MSB-aligned. A refill    *
+ * tops it up to at least 57 bits, so one bucket (prefix plus   *
+ * up to 12 bits) is decoded with a single refill check.        *
+ * ------------------------------------------------------------ */
+typedef struct { const uint8_t *p, *end; uint64_t acc; int nacc; } bitr;
+
+static inline void br_fill(bitr *r) {
+   while(r->nacc <= 56) {
+      uint64_t b = (r->p < r->end) ? *r->p++ : 0;
+      r->acc |= b << (56 - r->nacc);
+      r->nacc += 8;
+   }
+}
+
+static inline uint64_t br_get(bitr *r, int n) {
+   if(n > 32) {
+      uint64_t hi = br_get(r, n - 32);
+      return (hi << 32) | br_get(r, 32);
+   }
+   if(n == 0) return 0;
+   br_fill(r);
+   uint64_t v = r->acc >> (64 - n);
+   r->acc <<= n;
+   r->nacc -= n;
+   return v;
+}
+
+static inline int64_t br_bucket(bitr *r) {
+   br_fill(r);
+   if(!(r->acc >> 63)) { r->acc <<= 1; r->nacc -= 1; return 0; }
+   int lead = __builtin_clzll(~r->acc);
+   if(lead > 4) lead = 4;
+   int plen = (lead < 4) ? lead + 1 : 4;
+   r->acc <<= plen;
+   r->nacc -= plen;
+   return zz_dec(br_get(r, bucket_bits[lead]));
+}
+
+/* ------------------------------------------------------------ *
+ * encode_block() writes the header and all column streams of   *
+ * the n samples into buf. Returns the total byte size.         *
+ * ------------------------------------------------------------ */
+static size_t encode_block(const ss_sample *s, int n, uint8_t *buf) {
+   ss_blkhdr *hdr = (ss_blkhdr *) buf;
+   memset(hdr, 0, sizeof(ss_blkhdr));
+   hdr->magic = SS_MAGIC;
+   hdr->count = n;
+   hdr->first_ts = s[0].ts;
+   hdr->last_ts = s[n-1].ts;
+
+   size_t pos = sizeof(ss_blkhdr);
+   int i, c;
+
+   /* timestamp column, delta-of-delta */
+   bitw w = { buf + pos, 0, 0, 0 };
+   int64_t delta = 0;
+   bw_put(&w, (uint64_t) s[0].ts, 64);
+   for(i = 1; i < n; i++) {
+      int64_t d = s[i].ts - s[i-1].ts;
+      bw_bucket(&w, d - delta);
+      delta = d;
+   }
+   hdr->collen[0] = bw_flush(&w);
+   pos += hdr->collen[0];
+
+   /* value columns, delta */
+   for(c = 0; c < SS_COLS; c++) {
+      bitw v = { buf + pos, 0, 0, 0 };
+      int64_t prev = 0;
+      for(i = 0; i < n; i++) {
+         bw_bucket(&v, (int64_t) s[i].val[c] - prev);
+         prev = s[i].val[c];
+      }
+      hdr->collen[c+1] = bw_flush(&v);
+      pos += hdr->collen[c+1];
+   }
+   return pos;
+}
+
+static uint64_t block_size(const ss_blkhdr *hdr) {
+   uint64_t len = sizeof(ss_blkhdr);
+   int c;
+   for(c = 0; c <= SS_COLS; c++) len += hdr->collen[c];
+   return len;
+}
+
+/* ------------------------------------------------------------ *
+ * ss_decode() expands the columns selected in colmask into the *
+ * caller's arrays, which must hold hdr->count entries. Columns *
+ * not selected are skipped without decoding.                   *
+ * return code: number of samples, -1 for errors                *
+ * ------------------------------------------------------------ */
+int ss_decode(const ss_block *blk, unsigned colmask, int64_t *ts, int32_t *val[SS_COLS]) {
+   const ss_blkhdr *hdr = blk->hdr;
+   const uint8_t *p = blk->data;
+   int n = hdr->count;
+   int i, c;
+
+   bitr r = { p, p + hdr->collen[0], 0, 0 };
+   int64_t t = (int64_t) br_get(&r, 64);
+   int64_t delta = 0;
+   ts[0] = t;
+   for(i = 1; i < n; i++) {
+      delta += br_bucket(&r);
+      t += delta;
+      ts[i] = t;
+   }
+   p += hdr->collen[0];
+
+   for(c = 0; c < SS_COLS; c++) {
+      if(colmask & (1u << c)) {
+         bitr v = { p, p + hdr->collen[c+1], 0, 0 };
+         int32_t *out = val[c];
+         int64_t x = 0;
+         for(i = 0; i < n; i++) {
+            x += br_bucket(&v);
+            out[i] = (int32_t) x;
+         }
+      }
+      p += hdr->collen[c+1];
+   }
+   return n;
+}
+
+/* ------------------------------------------------------------ *
+ * ss_block_next() steps through the blocks of the .dat file.   *
+ * Start with *off = 0. Returns 1 if a block was found, 0 at    *
+ * the end of the file, or at a block with a bad header. The    *
+ * sample count is checked, ss_decode() fills fixed arrays of   *
+ * SS_BLOCK_MAX samples.                                        *
+ * ------------------------------------------------------------ */
+static int ss_block_next(const sstore *ss, size_t *off, ss_block *blk) {
+   if(*off + sizeof(ss_blkhdr) > ss->maplen) return 0;
+   const ss_blkhdr *hdr = (const ss_blkhdr *) (ss->map + *off);
+   if(hdr->magic != SS_MAGIC) return 0;
+   if(hdr->count == 0 || hdr->count > SS_BLOCK_MAX) return 0;
+   uint64_t len = block_size(hdr);
+   if(*off + len > ss->maplen) return 0;
+   blk->hdr = hdr;
+   blk->data = ss->map + *off + sizeof(ss_blkhdr);
+   *off += len;
+   return 1;
+}
+
+/* ------------------------------------------------------------ *
+ * ss_agg_init() .. ss_agg_block() accumulate one column. Data  *
+ * must be added in time order, so that the integral can join   *
+ * the last sample of one part with the first of the next.      *
+ * ------------------------------------------------------------ */
+void ss_agg_init(ss_agg *a) {
+   memset(a, 0, sizeof(ss_agg));
+   a->min = INT32_MAX;
+   a->max = INT32_MIN;
+}
+
+static void agg_join(ss_agg *a, int64_t ts, int32_t val) {
+   if(a->count > 0 && ts - a->last_ts <= SS_MAX_GAP)
+      a->area2 += ((int64_t) a->last + val) * (ts - a->last_ts);
+}
+
+void ss_agg_samples(ss_agg *a, const int64_t *ts, const int32_t *val, int n) {
+   int i;
+   if(n <= 0) return;
+   agg_join(a, ts[0], val[0]);
+   if(a->count == 0) a->first_ts = ts[0];
+   int32_t min = a->min, max = a->max;
+   int64_t sum = 0, area2 = 0;
+   for(i = 0; i < n; i++) {
+      if(val[i] < min) min = val[i];
+      if(val[i] > max) max = val[i];
+      sum += val[i];
+      if(i > 0 && ts[i] - ts[i-1] <= SS_MAX_GAP)
+         area2 += ((int64_t) val[i-1] + val[i]) * (ts[i] - ts[i-1]);
+   }
+   a->min = min;
+   a->max = max;
+   a->sum += sum;
+   a->area2 += area2;
+   a->count += n;
+   a->last_ts = ts[n-1];
+   a->last = val[n-1];
+}
+
+void ss_agg_block(ss_agg *a, const ss_idxent *ent, int col) {
+   const ss_colsum *cs = &ent->col[col];
+   agg_join(a, ent->first_ts, cs->first);
+   if(a->count == 0) a->first_ts = ent->first_ts;
+   if(cs->min < a->min) a->min = cs->min;
+   if(cs->max > a->max) a->max = cs->max;
+   a->sum += cs->sum;
+   a->area2 += cs->area2;
+   a->count += ent->count;
+   a->last_ts = ent->last_ts;
+   a->last = cs->last;
+}
+
+/* ------------------------------------------------------------ *
+ * ss_index_block() decodes a block and fills its index entry.  *
+ * return code: 0 = success, -1 for errors                      *
+ * ------------------------------------------------------------ */
+static int ss_index_block(const ss_block *blk, uint64_t offset, ss_idxent *ent) {
+   int64_t *ts = malloc(SS_BLOCK_MAX * sizeof(int64_t));
+   int32_t *buf = malloc(SS_BLOCK_MAX * SS_COLS * sizeof(int32_t));
+   if(ts == NULL || buf == NULL) { free(ts); free(buf); return(-1); }
+
+   int32_t *val[SS_COLS];
+   int c;
+   for(c = 0; c < SS_COLS; c++) val[c] = buf + c * SS_BLOCK_MAX;
+   int n = ss_decode(blk, SS_ALLCOLS, ts, val);
+
+   memset(ent, 0, sizeof(ss_idxent));
+   ent->first_ts = blk->hdr->first_ts;
+   ent->last_ts = blk->hdr->last_ts;
+   ent->offset = offset;
+   ent->count = n;
+   for(c = 0; c < SS_COLS; c++) {
+      ss_agg a;
+      ss_agg_init(&a);
+      ss_agg_samples(&a, ts, val[c], n);
+      ent->col[c].min = a.min;
+      ent->col[c].max = a.max;
+      ent->col[c].first = val[c][0];
+      ent->col[c].last = val[c][n-1];
+      ent->col[c].sum = a.sum;
+      ent->col[c].area2 = a.area2;
+   }
+   free(ts);
+   free(buf);
+   return(0);
+}
+
+/* ------------------------------------------------------------ *
+ * map_file() maps a store file read-only. A missing file is an *
+ * empty one unless we open the store for writing.              *
+ * ------------------------------------------------------------ */
+static int map_file(const char *file, int writable, const void **map, size_t *len) {
+   *map = NULL;
+   *len = 0;
+   int fd = open(file, writable ? O_RDWR | O_CREAT : O_RDONLY, 0644);
+   if(fd < 0 && errno == ENOENT) return(0);  // read-only, nothing sealed yet
+   if(fd < 0) {
+      fprintf(stderr, "Error: cannot open sample store %s: %s\n", file, strerror(errno));
+      return(-1);
+   }
+   struct stat st;
+   if(fstat(fd, &st) != 0) { close(fd); return(-1); }
+   if(st.st_size > 0) {
+      void *m = mmap(NULL, st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+      if(m == MAP_FAILED) {
+         fprintf(stderr, "Error: cannot map sample store %s\n", file);
+         close(fd);
+         return(-1);
+      }
+      *map = m;
+      *len = st.st_size;
+   }
+   close(fd);
+   return(0);
+}
+
+static void unmap_store(sstore *ss) {
+   if(ss->map) munmap((void *) ss->map, ss->maplen);
+   if(ss->idx && ss->idxlen > 0) munmap((void *) ss->idx, ss->idxlen);
+   free(ss->idxheap);
+   ss->map = NULL;
+   ss->idx = NULL;
+   ss->idxheap = NULL;
+   ss->maplen = ss->idxlen = 0;
+   ss->nidx = 0;
+}
+
+/* ------------------------------------------------------------ *
+ * map_store() maps .dat and .idx, and checks they match. Index *
+ * entries without a complete block are dropped, blocks without *
+ * an index entry get indexed. A block cut short by a crash     *
+ * during write is removed from the end of the .dat file. Only  *
+ * the blocks after the last good index entry are walked, so    *
+ * this stays cheap however long the history is.                *
+ * ------------------------------------------------------------ */
+static int map_store(sstore *ss) {
+   const void *m;
+   size_t len;
+
+   unmap_store(ss);
+   if(map_file(ss->datfile, ss->writable, &m, &len) != 0) return(-1);
+   ss->map = m;
+   ss->maplen = len;
+   if(map_file(ss->idxfile, ss->writable, &m, &len) != 0) return(-1);
+   ss->idx = m;
+   ss->idxlen = len;
+
+   /* trust index entries as far as they point to valid blocks */
+   int nidx = ss->idxlen / sizeof(ss_idxent);
+   size_t off = 0;
+   ss_block blk;
+   while(nidx > 0) {
+      off = ss->idx[nidx-1].offset;
+      if(ss_block_next(ss, &off, &blk) && blk.hdr->first_ts == ss->idx[nidx-1].first_ts) break;
+      nidx--;
+      off = 0;
+   }
+
+   /* walk the remaining blocks, these are not yet indexed */
+   size_t walk = off;
+   int missing = 0;
+   while(ss_block_next(ss, &walk, &blk)) missing++;
+
+   int fix = (walk != ss->maplen || missing > 0 || nidx * sizeof(ss_idxent) != ss->idxlen);
+   if(fix && ss->writable) {
+      if(walk != ss->maplen)
+         fprintf(stderr, "Error: sample store %s has %lu trailing bytes after last block\n",
+                 ss->datfile, (unsigned long) (ss->maplen - walk));
+      /* unmap first, a mapping past the new end of file faults */
+      unmap_store(ss);
+      if(truncate(ss->datfile, walk) != 0 ||
+         truncate(ss->idxfile, nidx * sizeof(ss_idxent)) != 0) {
+         fprintf(stderr, "Error: cannot repair sample store %s: %s\n", ss->datfile, strerror(errno));
+         return(-1);
+      }
+      if(map_file(ss->datfile, ss->writable, &m, &len) != 0) return(-1);
+      ss->map = m;
+      ss->maplen = len;
+      FILE *fp = fopen(ss->idxfile, "a");
+      if(fp == NULL) return(-1);
+      while(ss_block_next(ss, &off, &blk)) {
+         ss_idxent ent;
+         uint64_t pos = (const uint8_t *) blk.hdr - ss->map;
+         if(ss_index_block(&blk, pos, &ent) != 0) { fclose(fp); return(-1); }
+         fwrite(&ent, sizeof(ent), 1, fp);
+      }
+      fclose(fp);
+      return map_store(ss);
+   }
+
+   ss->nidx = nidx;
+   if(missing > 0) {
+      /* read-only and the index is stale: complete it in memory */
+      ss->idxheap = malloc((nidx + missing) * sizeof(ss_idxent));
+      if(ss->idxheap == NULL) return(-1);
+      if(nidx > 0) memcpy(ss->idxheap, ss->idx, nidx * sizeof(ss_idxent));
+      while(ss_block_next(ss, &off, &blk)) {
+         uint64_t pos = (const uint8_t *) blk.hdr - ss->map;
+         if(ss_index_block(&blk, pos, &ss->idxheap[ss->nidx]) != 0) return(-1);
+         ss->nidx++;
+      }
+      if(ss->idxlen > 0) munmap((void *) ss->idx, ss->idxlen);
+      ss->idx = ss->idxheap;
+      ss->idxlen = 0;
+   }
+   if(ss->nidx > 0) ss->last_ts = ss->idx[ss->nidx-1].last_ts;
+   return(0);
+}
+
+/* ------------------------------------------------------------ *
+ * ss_open() opens the store files named by base, e.g. base     *
+ * /home/pi/pi-solar/rrd/samples. With writable=1 missing files *
+ * are created.  return code: 0 = success, -1 for errors        *
+ * ------------------------------------------------------------ */
+int ss_open(sstore *ss, const char *base, int writable) {
+   memset(ss, 0, sizeof(sstore));
+   snprintf(ss->datfile, sizeof(ss->datfile), "%s.dat", base);
+   snprintf(ss->idxfile, sizeof(ss->idxfile), "%s.idx", base);
+   snprintf(ss->tailfile, sizeof(ss->tailfile), "%s.tail", base);
+   ss->writable = writable;
+   ss->last_ts = INT64_MIN;
+
+   ss->pend = malloc(SS_BLOCK_MAX * sizeof(ss_sample));
+   if(ss->pend == NULL) return(-1);
+   if(map_store(ss) != 0) { ss_close(ss); return(-1); }
+
+   /* ---------------------------------------------------------- *
+    * Load the unsealed tail. Samples already sealed into the    *
+    * .dat file (crash between seal and tail reset) are skipped. *
+    * ---------------------------------------------------------- */
+   FILE *tail = fopen(ss->tailfile, "r");
+   if(tail) {
+      ss_sample s;
+      while(ss->npend < SS_BLOCK_MAX && fread(&s, sizeof(s), 1, tail) == 1) {
+         if(s.ts <= ss->last_ts) continue;
+         ss->pend[ss->npend++] = s;
+         ss->last_ts = s.ts;
+      }
+      fclose(tail);
+   }
+   return(0);
+}
+
+void ss_close(sstore *ss) {
+   unmap_store(ss);
+   free(ss->pend);
+   ss->pend = NULL;
+   ss->npend = 0;
+}
+
+/* ------------------------------------------------------------ *
+ * seal_tail() compresses the pending samples into a new block, *
+ * appends it to the .dat file, its entry to the .idx file and  *
+ * resets the tail file. The entry is built from the encoded    *
+ * block, which also proves the block decodes correctly.        *
+ * ------------------------------------------------------------ */
+static int seal_tail(sstore *ss) {
+   uint8_t *buf = malloc(sizeof(ss_blkhdr) + (SS_COLS+1) * SS_COLBUF);
+   if(buf == NULL) return(-1);
+   size_t len = encode_block(ss->pend, ss->npend, buf);
+
+   ss_idxent ent;
+   ss_block blk = { (const ss_blkhdr *) buf, buf + sizeof(ss_blkhdr) };
+   if(ss_index_block(&blk, ss->maplen, &ent) != 0) { free(buf); return(-1); }
+
+   int fd = open(ss->datfile, O_WRONLY | O_APPEND | O_CREAT, 0644);
+   if(fd < 0 || write(fd, buf, len) != (ssize_t) len || fsync(fd) != 0) {
+      fprintf(stderr, "Error: cannot write block to %s: %s\n", ss->datfile, strerror(errno));
+      if(fd >= 0) close(fd);
+      free(buf);
+      return(-1);
+   }
+   close(fd);
+   free(buf);
+
+   fd = open(ss->idxfile, O_WRONLY | O_APPEND | O_CREAT, 0644);
+   if(fd < 0 || write(fd, &ent, sizeof(ent)) != sizeof(ent)) {
+      fprintf(stderr, "Error: cannot write index %s: %s\n", ss->idxfile, strerror(errno));
+      if(fd >= 0) close(fd);
+      return(-1);
+   }
+   close(fd);
+
+   if(truncate(ss->tailfile, 0) != 0 && errno != ENOENT) {
+      fprintf(stderr, "Error: cannot reset %s: %s\n", ss->tailfile, strerror(errno));
+      return(-1);
+   }
+   ss->npend = 0;
+   return map_store(ss);
+}
+
+/* ------------------------------------------------------------ *
+ * ss_append() adds one sample. Samples must arrive in time     *
+ * order. The tail block is sealed when the new sample falls    *
+ * into the next SS_BLOCK_SPAN period, or when it is full.      *
+ * return code: 0 = success, -1 for errors                      *
+ * ------------------------------------------------------------ */
+int ss_append(sstore *ss, const ss_sample *s) {
+   if(! ss->writable) return(-1);
+   if(s->ts <= ss->last_ts) {
+      fprintf(stderr, "Error: sample ts %lld is not newer than %lld, skipped.\n",
+              (long long) s->ts, (long long) ss->last_ts);
+      return(-1);
+   }
+   if(ss->npend > 0 && (ss->npend == SS_BLOCK_MAX ||
+      s->ts / SS_BLOCK_SPAN != ss->pend[0].ts / SS_BLOCK_SPAN)) {
+      if(seal_tail(ss) != 0) return(-1);
+   }
+
+   int fd = open(ss->tailfile, O_WRONLY | O_APPEND | O_CREAT, 0644);
+   if(fd < 0 || write(fd, s, sizeof(ss_sample)) != sizeof(ss_sample)) {
+      fprintf(stderr, "Error: cannot write sample to %s: %s\n", ss->tailfile, strerror(errno));
+      if(fd >= 0) close(fd);
+      return(-1);
+   }
+   close(fd);
+   ss->pend[ss->npend++] = *s;
+   ss->last_ts = s->ts;
+   return(0);
+}
+
+/* ------------------------------------------------------------ *
+ * ss_find() returns the first index entry whose last sample is *
+ * at or after from, or nidx if there is none (binary search).  *
+ * ------------------------------------------------------------ */
+int ss_find(const sstore *ss, int64_t from) {
+   int lo = 0, hi = ss->nidx;
+   while(lo < hi) {
+      int mid = (lo + hi) / 2;
+      if(ss->idx[mid].last_ts < from) lo = mid + 1;
+      else hi = mid;
+   }
+   return lo;
+}
+
+static void entry_block(const sstore *ss, const ss_idxent *ent, ss_block *blk) {
+   blk->hdr = (const ss_blkhdr *) (ss->map + ent->offset);
+   blk->data = ss->map + ent->offset + sizeof(ss_blkhdr);
+}
+
+/* ------------------------------------------------------------ *
+ * tail_columns() transposes the raw tail samples into columns. *
+ * ------------------------------------------------------------ */
+static int tail_columns(const sstore *ss, int64_t *ts, int32_t **val) {
+   int i, c;
+   for(i = 0; i < ss->npend; i++) {
+      ts[i] = ss->pend[i].ts;
+      for(c = 0; c < SS_COLS; c++) val[c][i] = ss->pend[i].val[c];
+   }
+   return ss->npend;
+}
+
+/* ------------------------------------------------------------ *
+ * clip() narrows the decoded samples [*lo, *hi) to [from, to]. *
+ * ------------------------------------------------------------ */
+static void clip(const int64_t *ts, int n, int64_t from, int64_t to, int *lo, int *hi) {
+   *lo = 0;
+   *hi = n;
+   while(*lo < n && ts[*lo] < from) (*lo)++;
+   while(*hi > *lo && ts[*hi-1] > to) (*hi)--;
+}
+
+/* ------------------------------------------------------------ *
+ * emit_range() hands the samples of one decoded block that lie *
+ * inside [from, to] to the callback.                           *
+ * ------------------------------------------------------------ */
+static void emit_range(int64_t *ts, int32_t **val, int n, int64_t from, int64_t to,
+                       unsigned colmask, ss_chunk_fn fn, void *arg) {
+   int lo, hi, c;
+   clip(ts, n, from, to, &lo, &hi);
+   if(hi <= lo) return;
+
+   int32_t *cols[SS_COLS];
+   for(c = 0; c < SS_COLS; c++)
+      cols[c] = (colmask & (1u << c)) ? val[c] + lo : NULL;
+   fn(ts + lo, cols, hi - lo, arg);
+}
+
+/* ------------------------------------------------------------ *
+ * read_blocks() decodes index entries [first, last), and with  *
+ * tail=1 also the unsealed tail, clipped to [from, to].        *
+ * ------------------------------------------------------------ */
+static int read_blocks(const sstore *ss, int first, int last, int tail, int64_t from,
+                       int64_t to, unsigned colmask, ss_chunk_fn fn, void *arg) {
+   int64_t *ts = malloc(SS_BLOCK_MAX * sizeof(int64_t));
+   int32_t *buf = malloc(SS_BLOCK_MAX * SS_COLS * sizeof(int32_t));
+   if(ts == NULL || buf == NULL) { free(ts); free(buf); return(-1); }
+
+   int32_t *val[SS_COLS];
+   int c, i;
+   for(c = 0; c < SS_COLS; c++) val[c] = buf + c * SS_BLOCK_MAX;
+
+   for(i = first; i < last && ss->idx[i].first_ts <= to; i++) {
+      ss_block blk;
+      entry_block(ss, &ss->idx[i], &blk);
+      int n = ss_decode(&blk, colmask, ts, val);
+      emit_range(ts, val, n, from, to, colmask, fn, arg);
+   }
+
+   if(tail == 1) {
+      int n = tail_columns(ss, ts, val);
+      emit_range(ts, val, n, from, to, colmask, fn, arg);
+   }
+   free(ts);
+   free(buf);
+   return(0);
+}
+
+/* ------------------------------------------------------------ *
+ * ss_read() decodes all samples with from <= ts <= to, block   *
+ * by block, and passes them to fn in time order. The first     *
+ * block is found through the index, blocks after the range    *
+ * end the scan.  return code: 0 = success, -1 for errors       *
+ * ------------------------------------------------------------ */
+int ss_read(const sstore *ss, int64_t from, int64_t to, unsigned colmask,
+            ss_chunk_fn fn, void *arg) {
+   return read_blocks(ss, ss_find(ss, from), ss->nidx, 1, from, to, colmask, fn, arg);
+}
+
+/* ------------------------------------------------------------ *
+ * ss_read_entry() decodes the block of index entry i only, and *
+ * ss_read_tail() only the unsealed tail, both clipped to the   *
+ * range. For callers that walk the index themselves.           *
+ * ------------------------------------------------------------ */
+int ss_read_entry(const sstore *ss, int i, int64_t from, int64_t to, unsigned colmask,
+                  ss_chunk_fn fn, void *arg) {
+   return read_blocks(ss, i, i + 1, 0, from, to, colmask, fn, arg);
+}
+
+int ss_read_tail(const sstore *ss, int64_t from, int64_t to, unsigned colmask,
+                 ss_chunk_fn fn, void *arg) {
+   return read_blocks(ss, 0, 0, 1, from, to, colmask, fn, arg);
+}
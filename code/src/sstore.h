@@ -0,0 +1,154 @@
+/* ------------------------------------------------------------ *
+ * file:        sstore.h                                        *
+ * purpose:     Raw sample store for the ve.direct readings.    *
+ *              Keeps the lossless sample history next to the   *
+ *              RRD database, compressed per column in blocks.  *
+ *                                                              *
+ * author:      10/18/2026 agent                                *
+ *                                                              *
+ * A store named "samples" consists of three files:             *
+ *   samples.dat   sealed, compressed blocks (append only)      *
+ *   samples.idx   one fixed-size entry per block, with time    *
+ *                 span, file offset and per-column summaries   *
+ *   samples.tail  raw samples of the block still being filled  *
+ *                                                              *
+ * Values are kept as the fixed-point integers received from    *
+ * the controller (mV, mA, W), never as floats, so the history  *
+ * is lossless. A block covers at most SS_BLOCK_SPAN seconds or *
+ * SS_BLOCK_MAX samples. Inside a block each column is its own  *
+ * bit stream: timestamps are delta-of-delta coded, values are  *
+ * delta coded, both with a zigzag variable-length bit bucket.  *
+ * Files are written in host byte order (Raspberry Pi and x86   *
+ * are both little endian).                                     *
+ *                                                              *
+ * The .idx file is sorted by time, so a range query finds its  *
+ * first block by binary search. Blocks completely inside the   *
+ * range are answered from the summaries without decoding. The  *
+ * index can always be rebuilt from the .dat file, ss_open()    *
+ * does this for blocks that are missing in the index.          *
+ * ------------------------------------------------------------ */
+#ifndef SSTORE_H
+#define SSTORE_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+#define SS_MAGIC       0x31425350  // "PSB1" block header marker
+#define SS_BLOCK_SPAN  3600        // seconds, blocks are hour-aligned
+#define SS_BLOCK_MAX   4096        // max samples per block
+#define SS_MAX_GAP     300         // seconds, larger gaps are not integrated
+
+/* ------------------------------------------------------------ *
+ * Value columns, in ve.direct base units as integers:          *
+ * vbat=V [mV], ibat=I [mA], vpnl=VPV [mV], ppnl=PPV [W],       *
+ * load=IL [mA], opcs=CS [code]. The timestamp column is kept   *
+ * separately and is always decoded.                            *
+ * ------------------------------------------------------------ */
+enum { SS_VBAT, SS_IBAT, SS_VPNL, SS_PPNL, SS_LOAD, SS_OPCS, SS_COLS };
+#define SS_ALLCOLS ((1u << SS_COLS) - 1)
+
+extern const char *ss_colname[SS_COLS];
+
+typedef struct {
+   int64_t ts;                 // Unix timestamp [s]
+   int32_t val[SS_COLS];       // column values, see enum above
+} ss_sample;
+
+/* ------------------------------------------------------------ *
+ * Block header in the .dat file, followed by the column bit    *
+ * streams in order timestamp, vbat, ibat, ... opcs.            *
+ * ------------------------------------------------------------ */
+typedef struct {
+   uint32_t magic;             // SS_MAGIC
+   uint32_t count;             // number of samples in the block
+   int64_t  first_ts;          // timestamp of first sample
+   int64_t  last_ts;           // timestamp of last sample
+   uint32_t collen[SS_COLS+1]; // byte length of each column stream
+   uint32_t reserved;
+} ss_blkhdr;
+
+typedef struct {
+   const ss_blkhdr *hdr;       // points into the mapped .dat file
+   const uint8_t *data;        // first column stream
+} ss_block;
+
+/* ------------------------------------------------------------ *
+ * Per-column block summary. area2 is twice the trapezoidal     *
+ * integral of the value over time [unit*s], kept as integer so *
+ * sums over many blocks stay exact. Intervals longer than      *
+ * SS_MAX_GAP (missing readings) are left out of the integral.  *
+ * ------------------------------------------------------------ */
+typedef struct {
+   int32_t min;
+   int32_t max;
+   int32_t first;              // first and last value, to join
+   int32_t last;               // the integral of adjacent blocks
+   int64_t sum;
+   int64_t area2;
+} ss_colsum;
+
+typedef struct {
+   int64_t  first_ts;
+   int64_t  last_ts;
+   uint64_t offset;            // block header position in .dat
+   uint32_t count;
+   uint32_t reserved;
+   ss_colsum col[SS_COLS];
+} ss_idxent;
+
+/* ------------------------------------------------------------ *
+ * Aggregate of one column over a time range, see solarq.c.     *
+ * ------------------------------------------------------------ */
+typedef struct {
+   int64_t count;
+   int32_t min;
+   int32_t max;
+   int64_t sum;
+   int64_t area2;              // 2x trapezoid integral [unit*s]
+   int64_t first_ts;
+   int64_t last_ts;
+   int32_t last;               // last value seen, for joining
+} ss_agg;
+
+typedef struct {
+   char datfile[256];
+   char idxfile[256];
+   char tailfile[256];
+   int writable;
+   const uint8_t *map;         // read-only mapping of .dat
+   size_t maplen;
+   const ss_idxent *idx;       // read-only mapping of .idx
+   size_t idxlen;              // mapped bytes of .idx
+   int nidx;                   // number of index entries
+   ss_idxent *idxheap;         // in-memory index, if .idx is stale
+   int64_t last_ts;            // newest sample in the store
+   ss_sample *pend;            // samples of the unsealed tail block
+   int npend;
+} sstore;
+
+/* ------------------------------------------------------------ *
+ * ss_chunk_fn receives decoded samples as column arrays. val[] *
+ * holds NULL for columns that were not requested in colmask.   *
+ * ------------------------------------------------------------ */
+typedef void (*ss_chunk_fn)(const int64_t *ts, int32_t *const *val, int n, void *arg);
+
+/* ------------------------------------------------------------ *
+ * Errors are printed to stderr: the stdout of getvictron is    *
+ * the RRD update string that solar-data.sh passes on.          *
+ * ------------------------------------------------------------ */
+int  ss_open(sstore *ss, const char *base, int writable);
+void ss_close(sstore *ss);
+int  ss_append(sstore *ss, const ss_sample *s);
+int  ss_decode(const ss_block *blk, unsigned colmask, int64_t *ts, int32_t *val[SS_COLS]);
+int  ss_read(const sstore *ss, int64_t from, int64_t to, unsigned colmask,
+             ss_chunk_fn fn, void *arg);
+int  ss_read_entry(const sstore *ss, int i, int64_t from, int64_t to, unsigned colmask,
+                   ss_chunk_fn fn, void *arg);
+int  ss_read_tail(const sstore *ss, int64_t from, int64_t to, unsigned colmask,
+                  ss_chunk_fn fn, void *arg);
+int  ss_find(const sstore *ss, int64_t from);
+void ss_agg_init(ss_agg *a);
+void ss_agg_samples(ss_agg *a, const int64_t *ts, const int32_t *val, int n);
+void ss_agg_block(ss_agg *a, const ss_idxent *ent, int col);
+
+#endif
@@ -0,0 +1,136 @@
+/* ------------------------------------------------------------ *
+ * file:        reduce_test.c                                   *
+ * purpose:     Check the SSE2/NEON rr_*() kernels against the  *
+ *              plain C loops, with NaN rows mixed in, strided  *
+ *              columns and lengths that leave rows over after  *
+ *              the vector passes.                              *
+ *                                                              *
+ * author:      10/18/2026 agent                                *
+ *                                                              *
+ * compile:     gcc -I.. ../reduce.c reduce_test.c -o           *
+ *              reduce_test -lm                                 *
+ * ------------------------------------------------------------ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include "reduce.h"
+
+#define MAXN    37             // rows, covers every n % 4
+#define STRIDE  3              // DS columns of the fake fetch
+
+int failed = 0;
+
+/* ------------------------------------------------------------ *
+ * The plain loops, same as the #else branch of reduce.c.       *
+ * ------------------------------------------------------------ */
+double ref_sum(const double *x, long n, unsigned long stride) {
+   double sum = 0.0;
+   int known = 0;
+   long k;
+   for(k = 0; k < n; k++)
+      if(! isnan(x[k * stride])) { sum = sum + x[k * stride]; known = 1; }
+   return(known ? sum : NAN);
+}
+
+double ref_dot(const double *a, const double *b, long n, unsigned long stride) {
+   double sum = 0.0;
+   int known = 0;
+   long k;
+   for(k = 0; k < n; k++)
+      if(! isnan(a[k * stride]) && ! isnan(b[k * stride])) {
+         sum = sum + a[k * stride] * b[k * stride];
+         known = 1;
+      }
+   return(known ? sum : NAN);
+}
+
+double ref_min(const double *x, long n, unsigned long stride) {
+   double m = INFINITY;
+   long k;
+   for(k = 0; k < n; k++)
+      if(x[k * stride] < m) m = x[k * stride];
+   return(isinf(m) ? NAN : m);
+}
+
+double ref_max(const double *x, long n, unsigned long stride) {
+   double m = -INFINITY;
+   long k;
+   for(k = 0; k < n; k++)
+      if(x[k * stride] > m) m = x[k * stride];
+   return(isinf(m) ? NAN : m);
+}
+
+/* ------------------------------------------------------------ *
+ * same() is true if both are NaN, or equal within the relative *
+ * error tol. The vector sums add in a different order.         *
+ * ------------------------------------------------------------ */
+int same(double got, double want, double tol) {
+   if(isnan(got) || isnan(want)) return(isnan(got) && isnan(want));
+   return(fabs(got - want) <= tol * (fabs(want) + 1.0));
+}
+
+void check(int ok, const char *what, double value) {
+   printf("%s: %s [%.3g]\n", ok ? "OK  " : "FAIL", what, value);
+   if(! ok) failed = 1;
+}
+
+/* ------------------------------------------------------------ *
+ * fill() writes MAXN rows of STRIDE columns. Column 0 and 1    *
+ * get NaN rows after the pattern: 0 none, 1 every third and    *
+ * runs at the start and end, 2 all unknown. Column 2 is also   *
+ * NaN in rows where column 1 is known, so rr_dot() must skip a *
+ * row if either of its values is unknown.                      *
+ * ------------------------------------------------------------ */
+void fill(double *x, int pattern) {
+   int k;
+   for(k = 0; k < MAXN; k++) {
+      x[k * STRIDE]     = 12.0 + 0.37 * k - 0.011 * k * k;
+      x[k * STRIDE + 1] = -3.5 + sin(k) * 100.0;
+      x[k * STRIDE + 2] = 1e3 / (k + 1);
+      if(pattern == 1 && (k % 3 == 1 || k < 2 || k > MAXN - 3)) {
+         x[k * STRIDE] = NAN;
+         x[k * STRIDE + 1] = NAN;
+      }
+      if(pattern == 1 && k % 5 == 2) x[k * STRIDE + 2] = NAN;
+      if(pattern == 2) x[k * STRIDE] = x[k * STRIDE + 1] = x[k * STRIDE + 2] = NAN;
+   }
+}
+
+int main(int argc, char *argv[]) {
+   static const char *pname[] = { "no NaN", "NaN mixed", "all NaN" };
+   double x[MAXN * STRIDE];
+   char what[128];
+   int pattern, c;
+   long n;
+
+   for(pattern = 0; pattern < 3; pattern++) {
+      fill(x, pattern);
+      int bad[4] = { 0, 0, 0, 0 };
+      for(n = 0; n <= MAXN; n++) {
+         /* the whole row block as one column, and each DS column */
+         if(! same(rr_sum(x, n * STRIDE, 1), ref_sum(x, n * STRIDE, 1), 1e-12))
+            bad[0]++;
+         for(c = 0; c < STRIDE; c++) {
+            const double *col = x + c, *oth = x + (c + 1) % STRIDE;
+            if(! same(rr_sum(col, n, STRIDE), ref_sum(col, n, STRIDE), 1e-12)) bad[0]++;
+            if(! same(rr_dot(col, oth, n, STRIDE), ref_dot(col, oth, n, STRIDE), 1e-12)) bad[1]++;
+            if(! same(rr_min(col, n, STRIDE), ref_min(col, n, STRIDE), 0)) bad[2]++;
+            if(! same(rr_max(col, n, STRIDE), ref_max(col, n, STRIDE), 0)) bad[3]++;
+         }
+         if(! same(rr_dot(x, x + 1, n, 1), ref_dot(x, x + 1, n, 1), 1e-12)) bad[1]++;
+         if(! same(rr_min(x, n, 1), ref_min(x, n, 1), 0)) bad[2]++;
+         if(! same(rr_max(x, n, 1), ref_max(x, n, 1), 0)) bad[3]++;
+      }
+      snprintf(what, sizeof(what), "rr_sum equals the plain loop, %s", pname[pattern]);
+      check(bad[0] == 0, what, bad[0]);
+      snprintf(what, sizeof(what), "rr_dot equals the plain loop, %s", pname[pattern]);
+      check(bad[1] == 0, what, bad[1]);
+      snprintf(what, sizeof(what), "rr_min equals the plain loop, %s", pname[pattern]);
+      check(bad[2] == 0, what, bad[2]);
+      snprintf(what, sizeof(what), "rr_max equals the plain loop, %s", pname[pattern]);
+      check(bad[3] == 0, what, bad[3]);
+   }
+
+   check(isnan(rr_sum(x, 0, 1)) && isnan(rr_min(x, 0, 1)), "no rows give NAN", 0);
+   exit(failed ? -1 : 0);
+}
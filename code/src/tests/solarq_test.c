@@ -0,0 +1,103 @@
+/* ------------------------------------------------------------ *
+ * file:        solarq_test.c                                   *
+ * purpose:     Check that the solarq group energies add up to  *
+ *              the energy integral over the full range, and    *
+ *              that a group gets printed for any column list.  *
+ *                                                              *
+ * author:      10/18/2026 agent                                *
+ *                                                              *
+ * compile:     gcc -I.. ../sstore.c solarq_test.c -lm -o       *
+ *              solarq_test, run from src with ./solarq built   *
+ * ------------------------------------------------------------ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <unistd.h>
+#include "sstore.h"
+
+#define T0     1792540800      // 2026-10-21 00:00 UTC
+#define HOURS  3
+#define STEP   7               // does not divide the group edges
+
+int failed = 0;
+
+/* ------------------------------------------------------------ *
+ * make_store() writes HOURS of samples, every STEP seconds:    *
+ * ppnl is a constant 10W in the first hour, then a ramp.       *
+ * ------------------------------------------------------------ */
+int make_store(const char *base) {
+   sstore ss;
+   ss_sample s;
+   if(ss_open(&ss, base, 1) != 0) return(-1);
+   for(int64_t t = T0; t < T0 + HOURS * 3600; t = t + STEP) {
+      memset(&s, 0, sizeof(s));
+      s.ts = t;
+      s.val[SS_VBAT] = 13200 + (t % 97);
+      s.val[SS_PPNL] = (t < T0 + 3600) ? 10 : 10 + (t - T0 - 3600) / 60;
+      if(ss_append(&ss, &s) != 0) { ss_close(&ss); return(-1); }
+   }
+   ss_close(&ss);
+   return(0);
+}
+
+/* ------------------------------------------------------------ *
+ * query() runs solarq with -a energy and the group argument,   *
+ * returns the number of rows, their energy sum and the energy  *
+ * of the first row.                                            *
+ * ------------------------------------------------------------ */
+int query(const char *base, const char *cols, const char *group, double *sum, double *first) {
+   char cmd[1024], line[256];
+   snprintf(cmd, sizeof(cmd), "TZ=UTC ./solarq -s %s -f %d -t %d -c %s -a energy %s",
+            base, T0, T0 + HOURS * 3600, cols, group);
+   FILE *fp = popen(cmd, "r");
+   if(fp == NULL) return(-1);
+
+   int rows = 0;
+   long long start, end, count;
+   double e;
+   *sum = 0;
+   while(fgets(line, sizeof(line), fp) != NULL) {
+      if(sscanf(line, "%lld,%lld,%lld,%lf", &start, &end, &count, &e) != 4) continue;
+      if(rows == 0) *first = e;
+      *sum += e;
+      rows++;
+   }
+   if(pclose(fp) != 0) return(-1);
+   return(rows);
+}
+
+void check(int ok, const char *what) {
+   printf("%s: %s\n", ok ? "OK  " : "FAIL", what);
+   if(! ok) failed = 1;
+}
+
+int main(int argc, char *argv[]) {
+   char dir[] = "/tmp/solarq_test.XXXXXX";
+   char base[256];
+   double total, sum, first;
+
+   if(mkdtemp(dir) == NULL) { printf("Error: cannot create temp dir.\n"); exit(-1); }
+   snprintf(base, sizeof(base), "%s/samples", dir);
+   if(make_store(base) != 0) { printf("Error: cannot create sample store.\n"); exit(-1); }
+
+   check(query(base, "ppnl", "", &total, &first) == 1, "ungrouped query returns one row");
+
+   int rows = query(base, "ppnl", "-g 15m", &sum, &first);
+   check(rows == HOURS * 4, "-c ppnl -g 15m returns a row per group");
+   check(fabs(first - 2.5) < 1e-6, "constant 10W over 15m is 2.5Wh");
+   check(fabs(sum - total) < 1e-6, "15m group energies add up to the range integral");
+
+   rows = query(base, "ppnl", "-g 1h", &sum, &first);
+   check(rows == HOURS, "-c ppnl -g 1h returns a row per group");
+   check(fabs(first - 10.0) < 1e-6, "constant 10W over 1h is 10Wh");
+   check(fabs(sum - total) < 1e-6, "1h group energies add up to the range integral");
+
+   rows = query(base, "vbat,ppnl", "-g 1h", &sum, &first);
+   check(rows == HOURS, "-c vbat,ppnl -g 1h returns a row per group");
+
+   char cmd[512];
+   snprintf(cmd, sizeof(cmd), "rm -rf %s", dir);
+   if(system(cmd) != 0) printf("Warning: cannot remove %s\n", dir);
+   exit(failed ? -1 : 0);
+}
@@ -0,0 +1,309 @@
+/* ------------------------------------------------------------ *
+ * file:        spa_test.c                                      *
+ * purpose:     Check the faster SPA variants, the batch        *
+ *              calculation and the sun rise/transit/set cache  *
+ *              against the full spa_calculate() with the error *
+ *              bounds stated in spa.h.                         *
+ *                                                              *
+ * author:      10/18/2026 agent                                *
+ *                                                              *
+ * compile:     gcc -I.. spa_test.c -o spa_test -lm             *
+ *                                                              *
+ * spa.c is included, not linked, so that the tests can reach   *
+ * its static functions.                                        *
+ * ------------------------------------------------------------ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <time.h>
+#include "spa.c"
+
+int failed = 0;
+
+/* sites from the tropics to the poles, some with a timezone */
+static const double site_lat[] = { 35.610381, 0.0, -33.9, 52.5, 69.5, -78.0, 89.0 };
+static const double site_lon[] = { 139.628999, -78.5, 151.2, 13.4, 18.9, 166.7, 0.0 };
+static const double site_tz[]  = { 9.0, -5.0, 10.0, 1.0, 1.0, 12.0, 0.0 };
+#define SITES ((int) (sizeof(site_lat) / sizeof(site_lat[0])))
+
+void check(int ok, const char *what, double value) {
+   printf("%s: %s [%.3g]\n", ok ? "OK  " : "FAIL", what, value);
+   if(! ok) failed = 1;
+}
+
+/* ------------------------------------------------------------ *
+ * set_site() fills spa with site i, set_time() with the local  *
+ * date and time of the Unix timestamp t.                       *
+ * ------------------------------------------------------------ */
+void set_site(spa_data *spa, int i) {
+   memset(spa, 0, sizeof(spa_data));
+   spa->latitude      = site_lat[i];
+   spa->longitude     = site_lon[i];
+   spa->timezone      = site_tz[i];
+   spa->delta_t       = 69;
+   spa->elevation     = 100;
+   spa->pressure      = 1010;
+   spa->temperature   = 15;
+   spa->slope         = 30;
+   spa->azm_rotation  = -10;
+   spa->atmos_refract = 0.5667;
+}
+
+void set_time(spa_data *spa, time_t t) {
+   struct tm tm;
+   time_t lt = t + (time_t) (spa->timezone * 3600);
+   gmtime_r(&lt, &tm);
+   spa->year   = tm.tm_year + 1900;
+   spa->month  = tm.tm_mon + 1;
+   spa->day    = tm.tm_mday;
+   spa->hour   = tm.tm_hour;
+   spa->minute = tm.tm_min;
+   spa->second = tm.tm_sec;
+}
+
+/* ------------------------------------------------------------ *
+ * test_fast() compares SPA_FAST_ZA_INC with SPA_ZA_INC from    *
+ * 1950 to 2200 while the sun is up, bound 0.011 degrees.       *
+ * ------------------------------------------------------------ */
+void test_fast() {
+   double mz = 0, mi = 0, ma = 0;
+   struct tm tm = {0};
+   tm.tm_year = 1950 - 1900;
+   tm.tm_mday = 1;
+   time_t t0 = timegm(&tm);
+   tm.tm_year = 2200 - 1900;
+   time_t t1 = timegm(&tm);
+
+   for(int i = 0; i < SITES; i++) {
+      for(time_t t = t0 + i * 613; t < t1; t = t + 3 * 86400 + 2417) {
+         spa_data full, fast;
+         set_site(&full, i);
+         set_time(&full, t);
+         fast = full;
+         full.function = SPA_ZA_INC;
+         fast.function = SPA_FAST_ZA_INC;
+         if(spa_calculate(&full) != 0 || spa_calculate(&fast) != 0) {
+            check(0, "spa_calculate() input values", t);
+            return;
+         }
+         if(full.zenith >= 90 || fast.zenith >= 90) continue;
+
+         double da = fabs(full.azimuth - fast.azimuth);
+         if(da > 180) da = 360 - da;
+         da = da * sin(deg2rad(full.zenith));
+         if(fabs(full.zenith - fast.zenith) > mz) mz = fabs(full.zenith - fast.zenith);
+         if(fabs(full.incidence - fast.incidence) > mi) mi = fabs(full.incidence - fast.incidence);
+         if(da > ma) ma = da;
+      }
+   }
+   check(mz <= 0.011, "fast zenith within 0.011 degrees", mz);
+   check(mi <= 0.011, "fast incidence within 0.011 degrees", mi);
+   check(ma <= 0.011, "fast azimuth * sin(zenith) within 0.011 degrees", ma);
+}
+
+/* ------------------------------------------------------------ *
+ * test_fast_values() checks that the fast mode sets all of the *
+ * intermediate values, close to the full SPA ones. They start  *
+ * as NAN, a value left unset stays NAN and fails.              *
+ * ------------------------------------------------------------ */
+void test_fast_values() {
+   double m[6] = { 0 };
+   for(int i = 0; i < SITES; i++) {
+      spa_data full, fast;
+      set_site(&full, i);
+      set_time(&full, 1792325000 + i * 86400 * 50);
+      fast = full;
+      fast.jme = fast.l = fast.b = fast.theta = NAN;
+      fast.x0 = fast.x1 = fast.x2 = fast.x3 = fast.x4 = NAN;
+      fast.del_epsilon = fast.epsilon0 = fast.del_tau = NAN;
+      full.function = SPA_ZA;
+      fast.function = SPA_FAST_ZA;
+      spa_calculate(&full);
+      spa_calculate(&fast);
+
+      double d[6] = { fabs(full.jme - fast.jme),
+                      fabs(full.x0 - fast.x0) + fabs(full.x1 - fast.x1) + fabs(full.x2 - fast.x2) +
+                      fabs(full.x3 - fast.x3) + fabs(full.x4 - fast.x4),
+                      fabs(full.l - fast.l) + fabs(full.b - fast.b) + fabs(full.theta - fast.theta),
+                      fabs(full.epsilon0 - fast.epsilon0),
+                      fabs(full.del_epsilon - fast.del_epsilon),
+                      fabs(full.del_tau - fast.del_tau) };
+      for(int k = 0; k < 6; k++) if(isnan(d[k]) || d[k] > m[k]) m[k] = d[k];
+   }
+   check(m[0] == 0, "fast jme is set", m[0]);
+   check(m[1] == 0, "fast x0..x4 are set", m[1]);
+   check(m[2] < 0.01, "fast l, b, theta within 0.01 degrees", m[2]);
+   check(m[3] < 0.1, "fast epsilon0 within 0.1 arc seconds", m[3]);
+   check(m[4] < 0.001, "fast del_epsilon within 0.001 degrees", m[4]);
+   check(m[5] < 0.0001, "fast del_tau within 0.0001 degrees", m[5]);
+}
+
+/* ------------------------------------------------------------ *
+ * test_batch() compares spa_calculate_batch() with one         *
+ * spa_calculate() call per timestamp, every minute of two days *
+ * at each site. The batch does the same steps in another order *
+ * (up to 6e-7 degrees in azimuth near the pole), the sun rise, *
+ * transit and set are for the same local day and are equal.    *
+ * ------------------------------------------------------------ */
+#define BATCH_COUNT (2 * 1440)
+
+void test_batch() {
+   static time_t ts[BATCH_COUNT];
+   static double z[BATCH_COUNT], a[BATCH_COUNT], inc[BATCH_COUNT];
+   static double st[BATCH_COUNT], sr[BATCH_COUNT], ss[BATCH_COUNT];
+   spa_batch out = { z, a, inc, st, sr, ss };
+   double mz = 0, ma = 0, mi = 0, mr = 0;
+
+   for(int i = 0; i < SITES; i++) {
+      spa_data spa;
+      set_site(&spa, i);
+      spa.function = SPA_ALL;
+      for(int k = 0; k < BATCH_COUNT; k++) ts[k] = 1792325000 + i * 86400 * 50 + k * 60;
+      if(spa_calculate_batch(&spa, ts, BATCH_COUNT, &out) != 0) {
+         check(0, "spa_calculate_batch() input values", i);
+         return;
+      }
+      for(int k = 0; k < BATCH_COUNT; k++) {
+         spa_data one = spa;
+         set_time(&one, ts[k]);
+         spa_calculate(&one);
+
+         double da = fabs(one.azimuth - a[k]);
+         if(da > 180) da = 360 - da;
+         if(fabs(one.zenith - z[k]) > mz) mz = fabs(one.zenith - z[k]);
+         if(da > ma) ma = da;
+         if(fabs(one.incidence - inc[k]) > mi) mi = fabs(one.incidence - inc[k]);
+         double dr = fabs(one.suntransit - st[k]) + fabs(one.sunrise - sr[k]) +
+                     fabs(one.sunset - ss[k]);
+         if(isnan(dr) || dr > mr) mr = dr;
+      }
+   }
+   check(mz <= 1e-6, "batch zenith within 1e-6 degrees", mz);
+   check(ma <= 1e-6, "batch azimuth within 1e-6 degrees", ma);
+   check(mi <= 1e-6, "batch incidence within 1e-6 degrees", mi);
+   check(mr == 0, "batch sun rise, transit and set are equal", mr);
+}
+
+/* ------------------------------------------------------------ *
+ * test_rts_cache() calls spa_calculate() for a mix of dates,   *
+ * sites and settings, a few at a time so that the cache both   *
+ * hits and replaces entries, and checks the sun rise, transit  *
+ * and set against the values calculated with an empty cache.   *
+ * The case settings change one cache key each, with the same   *
+ * date and time, so a key missing in the lookup is caught.     *
+ * ------------------------------------------------------------ */
+#define RTS_VARIANTS 6
+#define RTS_CASES    (SITES * 2 * RTS_VARIANTS)
+
+void rts_case(spa_data *spa, int c) {
+   int v = c % RTS_VARIANTS;
+   set_site(spa, c / (2 * RTS_VARIANTS));
+   spa->function = SPA_ZA_RTS;
+   spa->year     = 2026;
+   spa->month    = 10;
+   spa->day      = 21 + (c / RTS_VARIANTS) % 2;
+   if(v == 1) spa->delta_t       = 70;
+   if(v == 2) spa->atmos_refract = 0.6;
+   if(v == 3) spa->timezone      = spa->timezone + 1;
+   if(v == 4) spa->latitude      = spa->latitude * 0.99;
+   if(v == 5) spa->longitude     = spa->longitude + 1;
+}
+
+void test_rts_cache() {
+   static double ref[RTS_CASES][6];
+   double m = 0;
+   int hits = 0;
+
+   for(int c = 0; c < RTS_CASES; c++) {
+      spa_data spa;
+      rts_case(&spa, c);
+      memset(rts_cache, 0, sizeof(rts_cache));
+      spa_calculate(&spa);
+      double r[6] = { spa.srha, spa.ssha, spa.sta, spa.suntransit, spa.sunrise, spa.sunset };
+      memcpy(ref[c], r, sizeof(r));
+   }
+
+   srand(1);
+   for(int n = 0; n < 20000; n++) {
+      spa_data spa;
+      int c = (n / 16 + rand() % 6) % RTS_CASES;
+      rts_case(&spa, c);
+      spa.hour   = rand() % 24;
+      spa.minute = rand() % 60;
+      if(rts_cache_find(&spa) != NULL) hits++;
+      spa_calculate(&spa);
+
+      double r[6] = { spa.srha, spa.ssha, spa.sta, spa.suntransit, spa.sunrise, spa.sunset };
+      for(int k = 0; k < 6; k++)
+         if(isnan(r[k]) || fabs(r[k] - ref[c][k]) > m) m = fabs(r[k] - ref[c][k]);
+   }
+   check(hits > 5000 && hits < 19000, "rts cache hits and replaces entries", hits);
+   check(m == 0, "cached sun rise, transit and set equal the uncached ones", m);
+}
+
+/* ------------------------------------------------------------ *
+ * test_simd() compares the vector path of the periodic terms   *
+ * with the scalar one: v_cos() against cos() for the argument  *
+ * range of the terms, and the earth heliocentric L, B and R    *
+ * from -2000 to 6000 (jme -4 to 4) against plain cos() sums.   *
+ * The sums add in another order, the powers of jme magnify the *
+ * rounding to 2e-9 degrees in L, so the bound is 1e-8 degrees, *
+ * far below the 0.0003 degrees of the SPA itself. Nothing to   *
+ * compare if spa.c has no vector path here.                    *
+ * ------------------------------------------------------------ */
+#ifdef SPA_SIMD
+double scalar_sum(const double terms[][TERM_COUNT], int count, double jme) {
+   double sum = 0;
+   for(int i = 0; i < count; i++)
+      sum += terms[i][TERM_A] * cos(terms[i][TERM_B] + terms[i][TERM_C] * jme);
+   return sum;
+}
+
+void test_simd() {
+   double in[SPA_SIMD], out[SPA_SIMD], mc = 0, ml = 0, mb = 0, mr = 0;
+   vdbl v;
+
+   for(double x = -2e5; x < 2e5; x = x + 0.7313) {
+      for(int i = 0; i < SPA_SIMD; i++) in[i] = x + i * 0.1;
+      memcpy(&v, in, sizeof(v));
+      v = v_cos(v);
+      memcpy(out, &v, sizeof(v));
+      for(int i = 0; i < SPA_SIMD; i++)
+         if(fabs(out[i] - cos(in[i])) > mc) mc = fabs(out[i] - cos(in[i]));
+   }
+   check(mc <= 4.5e-16, "v_cos() within 2 ulp of cos()", mc);
+
+   for(double jme = -4; jme < 4; jme = jme + 0.0007) {
+      double l[L_COUNT], b[B_COUNT], r[R_COUNT];
+      for(int i = 0; i < L_COUNT; i++) l[i] = scalar_sum(L_TERMS[i], l_subcount[i], jme);
+      for(int i = 0; i < B_COUNT; i++) b[i] = scalar_sum(B_TERMS[i], b_subcount[i], jme);
+      for(int i = 0; i < R_COUNT; i++) r[i] = scalar_sum(R_TERMS[i], r_subcount[i], jme);
+
+      double dl = fabs(earth_heliocentric_longitude(jme) -
+                       limit_degrees(rad2deg(earth_values(l, L_COUNT, jme))));
+      double db = fabs(earth_heliocentric_latitude(jme) - rad2deg(earth_values(b, B_COUNT, jme)));
+      double dr = fabs(earth_radius_vector(jme) - earth_values(r, R_COUNT, jme));
+      if(dl > 180) dl = 360 - dl;
+      if(dl > ml) ml = dl;
+      if(db > mb) mb = db;
+      if(dr > mr) mr = dr;
+   }
+   check(ml <= 1e-8, "vector L within 1e-8 degrees of scalar", ml);
+   check(mb <= 1e-8, "vector B within 1e-8 degrees of scalar", mb);
+   check(mr <= 1e-12, "vector R within 1e-12 AU of scalar", mr);
+}
+#else
+void test_simd() {
+   printf("SKIP: spa.c uses the scalar path only\n");
+}
+#endif
+
+int main(int argc, char *argv[]) {
+   test_fast();
+   test_fast_values();
+   test_batch();
+   test_rts_cache();
+   test_simd();
+   exit(failed ? -1 : 0);
+}
@@ -0,0 +1,219 @@
+/* ------------------------------------------------------------ *
+ * file:        sstore_test.c                                   *
+ * purpose:     Check that the sample store returns exactly the *
+ *              samples written, also with values that need the *
+ *              64 bit bucket, that blocks with a bad header    *
+ *              end the block walk, and that ss_open() repairs  *
+ *              a .dat with a partial block and a short .idx.   *
+ *                                                              *
+ * author:      10/18/2026 agent                                *
+ *                                                              *
+ * compile:     gcc -I.. sstore_test.c -o sstore_test -lm       *
+ *                                                              *
+ * sstore.c is included, not linked, so that the tests can      *
+ * reach its static functions.                                  *
+ * ------------------------------------------------------------ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include "sstore.c"
+
+#define T0     1792540800      // 2026-10-21 00:00 UTC
+#define NSAMP  1000
+
+int failed = 0;
+
+void check(int ok, const char *what) {
+   printf("%s: %s\n", ok ? "OK  " : "FAIL", what);
+   if(! ok) failed = 1;
+}
+
+/* small LCG, so the samples are the same on every run */
+static uint32_t seed = 12345;
+static uint32_t next_rand(void) { seed = seed * 1103515245 + 12345; return seed >> 1; }
+
+/* ------------------------------------------------------------ *
+ * make_samples() fills s with n samples. Gaps vary from 1s to  *
+ * 25 minutes, ibat jumps between INT32_MIN and INT32_MAX, so   *
+ * both columns hit every bucket size incl. the 64 bit one.     *
+ * ------------------------------------------------------------ */
+void make_samples(ss_sample *s, int n) {
+   int64_t t = T0;
+   int i;
+   for(i = 0; i < n; i++) {
+      t += (i % 50 == 49) ? 1500 : 1 + next_rand() % 20;
+      memset(&s[i], 0, sizeof(ss_sample));
+      s[i].ts = t;
+      s[i].val[SS_VBAT] = 13000 + next_rand() % 600;
+      s[i].val[SS_IBAT] = (i % 7 == 3) ? INT32_MIN : (i % 7 == 4) ? INT32_MAX : (int32_t) next_rand() - 20000;
+      s[i].val[SS_VPNL] = (int32_t) (next_rand() << 1);
+      s[i].val[SS_PPNL] = 0;
+      s[i].val[SS_LOAD] = -(int32_t) (next_rand() % 5000);
+      s[i].val[SS_OPCS] = (i / 100) % 3 == 0 ? 0 : 3;
+   }
+}
+
+/* collects what ss_read() passes to the callback */
+typedef struct { ss_sample *s; int n; } collect;
+
+void collect_fn(const int64_t *ts, int32_t *const *val, int n, void *arg) {
+   collect *cl = (collect *) arg;
+   int i, c;
+   for(i = 0; i < n && cl->n < NSAMP; i++, cl->n++) {
+      memset(&cl->s[cl->n], 0, sizeof(ss_sample));
+      cl->s[cl->n].ts = ts[i];
+      for(c = 0; c < SS_COLS; c++) cl->s[cl->n].val[c] = val[c][i];
+   }
+}
+
+/* ------------------------------------------------------------ *
+ * read_all() opens the store and compares all samples with s.  *
+ * return code: number of index entries, -1 for errors          *
+ * ------------------------------------------------------------ */
+int read_all(const char *base, int writable, const ss_sample *s, int n, int *same) {
+   sstore ss;
+   collect cl = { malloc(NSAMP * sizeof(ss_sample)), 0 };
+   *same = 0;
+   if(cl.s == NULL || ss_open(&ss, base, writable) != 0) { free(cl.s); return(-1); }
+   ss_read(&ss, INT64_MIN, INT64_MAX, SS_ALLCOLS, collect_fn, &cl);
+   *same = (cl.n == n && memcmp(cl.s, s, n * sizeof(ss_sample)) == 0);
+   int nidx = ss.nidx;
+   ss_close(&ss);
+   free(cl.s);
+   return(nidx);
+}
+
+/* counts the blocks ss_block_next() accepts in buf */
+int count_blocks(const uint8_t *buf, size_t len) {
+   sstore ss;
+   ss_block blk;
+   size_t off = 0;
+   int n = 0;
+   memset(&ss, 0, sizeof(ss));
+   ss.map = buf;
+   ss.maplen = len;
+   while(ss_block_next(&ss, &off, &blk)) n++;
+   return(n);
+}
+
+off_t file_size(const char *file) {
+   struct stat st;
+   return (stat(file, &st) == 0) ? st.st_size : -1;
+}
+
+int main(int argc, char *argv[]) {
+   char dir[] = "/tmp/sstore_test.XXXXXX";
+   char base[256];
+   ss_sample *s = malloc(NSAMP * sizeof(ss_sample));
+   int i, same;
+
+   if(s == NULL) { printf("Error: out of memory.\n"); exit(-1); }
+   if(mkdtemp(dir) == NULL) { printf("Error: cannot create temp dir.\n"); exit(-1); }
+   snprintf(base, sizeof(base), "%s/samples", dir);
+   make_samples(s, NSAMP);
+
+   /* ---------------------------------------------------------- *
+    * One full block, encoded and decoded without the files. It  *
+    * uses the 64 bit bucket for every sample, the worst case    *
+    * size must still fit the seal buffer.                       *
+    * ---------------------------------------------------------- */
+   ss_sample *big = malloc(SS_BLOCK_MAX * sizeof(ss_sample));
+   uint8_t *buf = malloc(2 * (sizeof(ss_blkhdr) + (SS_COLS+1) * SS_COLBUF));
+   int64_t *ts = malloc(SS_BLOCK_MAX * sizeof(int64_t));
+   int32_t *colbuf = malloc(SS_BLOCK_MAX * SS_COLS * sizeof(int32_t));
+   if(big == NULL || buf == NULL || ts == NULL || colbuf == NULL) {
+      printf("Error: out of memory.\n");
+      exit(-1);
+   }
+   int32_t *val[SS_COLS];
+   int c;
+   for(c = 0; c < SS_COLS; c++) val[c] = colbuf + c * SS_BLOCK_MAX;
+   for(i = 0; i < SS_BLOCK_MAX; i++) {
+      big[i].ts = (i == 0) ? T0 : big[i-1].ts + ((i % 2) ? 1 : 100000);
+      for(c = 0; c < SS_COLS; c++) big[i].val[c] = (i + c) % 2 ? INT32_MAX : INT32_MIN;
+   }
+   size_t len = encode_block(big, SS_BLOCK_MAX, buf);
+   ss_block blk = { (const ss_blkhdr *) buf, buf + sizeof(ss_blkhdr) };
+   int n = ss_decode(&blk, SS_ALLCOLS, ts, val);
+   int ok = (n == SS_BLOCK_MAX);
+   for(i = 0; ok && i < n; i++) {
+      ok = (ts[i] == big[i].ts);
+      for(c = 0; c < SS_COLS; c++) ok = ok && (val[c][i] == big[i].val[c]);
+   }
+   check(ok, "full block with 64 bit buckets decodes to the samples");
+   check(len <= sizeof(ss_blkhdr) + (SS_COLS+1) * SS_COLBUF, "full block fits the seal buffer");
+
+   /* ---------------------------------------------------------- *
+    * A block with a bad sample count or cut short ends the walk *
+    * ---------------------------------------------------------- */
+   size_t len2 = encode_block(s, 100, buf + len);
+   check(count_blocks(buf, len + len2) == 2, "two good blocks are walked");
+   ss_blkhdr *hdr2 = (ss_blkhdr *) (buf + len);
+   hdr2->count = 0;
+   check(count_blocks(buf, len + len2) == 1, "block with count 0 ends the walk");
+   hdr2->count = SS_BLOCK_MAX + 1;
+   check(count_blocks(buf, len + len2) == 1, "block with count above SS_BLOCK_MAX ends the walk");
+   hdr2->count = 100;
+   check(count_blocks(buf, len + len2 - 1) == 1, "truncated block ends the walk");
+   hdr2->magic = 0;
+   check(count_blocks(buf, len + len2) == 1, "block with bad magic ends the walk");
+   free(big);
+   free(buf);
+   free(ts);
+   free(colbuf);
+
+   /* ---------------------------------------------------------- *
+    * Round trip through the store files, sealed blocks and tail *
+    * ---------------------------------------------------------- */
+   sstore ss;
+   if(ss_open(&ss, base, 1) != 0) { printf("Error: cannot create sample store.\n"); exit(-1); }
+   for(i = 0; i < NSAMP; i++)
+      if(ss_append(&ss, &s[i]) != 0) { printf("Error: cannot append sample %d.\n", i); exit(-1); }
+   ss_close(&ss);
+
+   char datfile[512], idxfile[512];
+   snprintf(datfile, sizeof(datfile), "%s.dat", base);
+   snprintf(idxfile, sizeof(idxfile), "%s.idx", base);
+   off_t datlen = file_size(datfile);
+   off_t idxlen = file_size(idxfile);
+
+   int nidx = read_all(base, 0, s, NSAMP, &same);
+   check(nidx > 2, "samples span several sealed blocks");
+   check(same, "read back equals the samples written");
+
+   /* ---------------------------------------------------------- *
+    * Repair: a partial block at the end of .dat, as left by a   *
+    * crash during write, and the last .idx entry missing.       *
+    * ---------------------------------------------------------- */
+   FILE *fp = fopen(datfile, "a");
+   if(fp == NULL) { printf("Error: cannot open %s.\n", datfile); exit(-1); }
+   ss_blkhdr part;
+   memset(&part, 0, sizeof(part));
+   part.magic = SS_MAGIC;
+   part.count = 10;
+   part.collen[0] = 1000;
+   fwrite(&part, sizeof(part), 1, fp);
+   fwrite(s, sizeof(ss_sample), 3, fp);
+   fclose(fp);
+   if(truncate(idxfile, idxlen - sizeof(ss_idxent)) != 0) {
+      printf("Error: cannot truncate %s.\n", idxfile);
+      exit(-1);
+   }
+
+   check(read_all(base, 0, s, NSAMP, &same) == nidx, "read-only open indexes the missing block");
+   check(same, "read-only open still reads all samples");
+   check(file_size(datfile) > datlen, "read-only open leaves .dat alone");
+
+   check(read_all(base, 1, s, NSAMP, &same) == nidx, "writable open rebuilds the index");
+   check(same, "repaired store reads all samples");
+   check(file_size(datfile) == datlen, "partial block is cut from .dat");
+   check(file_size(idxfile) == idxlen, "missing .idx entry is written");
+
+   char cmd[512];
+   snprintf(cmd, sizeof(cmd), "rm -rf %s", dir);
+   if(system(cmd) != 0) printf("Warning: cannot remove %s\n", dir);
+   free(s);
+   exit(failed ? -1 : 0);
+}
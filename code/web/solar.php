@@ -51,6 +51,7 @@
 <hr />
 <div class="showext" id="s_term" style="display: none;">
 <?php include("./daypower.htm"); ?>
+<?php include("./daymimax.htm"); ?>
 <p>
 <div class="fullgraph"> <img src="images/monthly_vbat.png" alt="Weekly Battery Voltage"> </div>
 <div class="fullgraph"> <img src="images/monthly_vpnl.png" alt="Weekly Panel Voltage"> </div>